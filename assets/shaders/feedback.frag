@@ -0,0 +1,26 @@
+#version 330 core
+
+// Writes the virtual texture page every texel would sample, packed like PageCache::Pack. Drawn into the
+// FeedbackBuffer, texels of bodies without a virtual texture stay empty but still hide what is behind them
+
+#include "virtual.glsl"
+
+uniform float lodBias; // the feedback target is smaller than the window, each of its texels covers more texture
+
+in vec2 uvOut;
+flat in int virtualTexture;
+out uint feedback;
+
+void main()
+{
+	if (virtualTexture < 0)
+	{
+		feedback = 0xFFFFFFFFu;
+		return;
+	}
+
+	vec2 uv = clamp(uvOut, vec2(0.0), vec2(0.99999));
+	float level = clamp(floor(VirtualLevel(uv) + lodBias), 0.0, virtualSize.z - 1.0);
+	uvec2 page = uvec2(uv * virtualSize.xy / exp2(level) / PageSize);
+	feedback = uint(virtualTexture) << 28 | uint(level) << 24 | page.y << 12 | page.x;
+}
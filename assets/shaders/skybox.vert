@@ -0,0 +1,16 @@
+#version 330 core
+
+uniform mat4 inverseViewProjection; // of the view rotation only, the sky is infinitely far away
+
+out vec3 direction;
+
+void main()
+{
+	// one triangle covering the screen, its corners at (-1, -1), (3, -1) and (-1, 3)
+	vec2 position = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2)) * 2.0 - 1.0;
+
+	// at the far plane, so it only fills what the bodies left of the cleared depth
+	gl_Position = vec4(position, 1.0, 1.0);
+	vec4 world = inverseViewProjection * vec4(position, 1.0, 1.0);
+	direction = world.xyz / world.w;
+}
@@ -1,9 +1,18 @@
 #version 330 core
 
-uniform sampler2D baseColorTexture;
-uniform sampler2D overlayColorTexture;
+// Compiled once per combination of the features SolarSystem draws with, see SolarSystem::ShaderFeature:
+//   UNLIT       the texture color as is, for the sun and the clouds
+//   ALPHA_TEST  discards nearly transparent fragments, only blended draws use it so opaque ones keep early-z
+//   NIGHT_MAP   adds the lights of nightMapTexture where the surface turns away from the light
+//   RING        samples baseColorTexture instead of the body textures
+
+#include "virtual.glsl"
 
-uniform bool noShade = false;
+uniform sampler2D baseColorTexture;
+uniform sampler2D nightMapTexture;
+uniform sampler2DArray bodyTextures; // textures of all bodies, one layer each
+uniform sampler2D pageCache; // pages of every virtual texture, see PageCache
+uniform sampler2D pageTable; // of the virtual texture drawn, one texel per page and a level per page level
 
 uniform vec3 lightColor;
 uniform vec3 lightPos;
@@ -13,25 +22,45 @@ in vec3 Normal;
 in vec3 FragPos;
 in vec3 outColor;
 in vec2 uvOut;
+flat in int layer;
+flat in int virtualTexture;
 out vec4 fragColor;
 
+// bilinear sample of the resident page covering uv at the wanted level, or of its nearest resident ancestor
+vec4 SampleVirtual(vec2 uv)
+{
+	uv = clamp(uv, vec2(0.0), vec2(0.99999));
+	int level = int(clamp(floor(VirtualLevel(uv)), 0.0, virtualSize.z - 1.0));
+	ivec2 page = ivec2(uv * virtualSize.xy / exp2(float(level)) / PageSize);
+	page = clamp(page, ivec2(0), textureSize(pageTable, level) - 1);
+	vec3 entry = floor(texelFetch(pageTable, page, level).xyz * 255.0 + 0.5); // slot x, slot y, level of the page
+
+	vec2 texel = uv * virtualSize.xy / exp2(entry.z);
+	vec2 inPage = texel - floor(texel / PageSize) * PageSize;
+	float paddedSize = PageSize + 2.0 * PageBorder;
+	vec2 cacheUv = (entry.xy * paddedSize + PageBorder + inPage) / (virtualSize.w * paddedSize);
+	return textureLod(pageCache, cacheUv, 0.0);
+}
+
 void main()
 {	
+#ifdef RING
 	vec4 sampledColor = texture(baseColorTexture, uvOut);
+#else
+	vec4 sampledColor = virtualTexture >= 0 ? SampleVirtual(uvOut) : texture(bodyTextures, vec3(uvOut, float(layer)));
+#endif
 	
+#ifdef ALPHA_TEST
 	// discard transparent fragments
 	if (sampledColor.a < 0.1)
 	{
 		discard;
 	}
+#endif
 
-	// do not shade the fragment if noShade is true (used for clouds and sun)
-	if (noShade)
-	{
-		fragColor = sampledColor;
-		return;
-	}
-	
+#ifdef UNLIT
+	fragColor = sampledColor;
+#else
 	// caclulate the ambient light on the fragment
 	float ambientStrength = 0.5;
 	vec3 ambient = ambientStrength * lightColor;
@@ -51,5 +80,12 @@ void main()
 	vec3 specular = specularStrength * spec * lightColor;
 	
 	// calculate the final color of the fragment
-	fragColor = vec4((ambient + diffuse + specular) * sampledColor.rgb, 1.0);
+	vec3 color = (ambient + diffuse + specular) * sampledColor.rgb;
+#ifdef NIGHT_MAP
+	// the lights fade in across the terminator
+	float night = 1.0 - smoothstep(-0.2, 0.1, dot(norm, lightDir));
+	color += night * texture(nightMapTexture, uvOut).rgb;
+#endif
+	fragColor = vec4(color, 1.0);
+#endif
 }
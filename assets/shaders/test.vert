@@ -1,24 +1,43 @@
 #version 330 core
 
+#define MAX_DRAWS 64
+
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inColor;
 layout (location = 2) in vec3 inNormal;
 layout (location = 3) in vec2 uvIn;
+layout (location = 4) in int drawId; // DrawBlock entry from the baseInstance of an indirect draw, -1 otherwise
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec3 outColor;
 out vec2 uvOut;
+flat out int layer;
+flat out int virtualTexture;
+
+struct DrawData
+{
+	mat4 mvp;
+	mat4 model;
+	mat4 normalMatrix;
+	ivec4 flags;
+};
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-draw data streamed by the CPU, baseDraw selects the entry of the current draw, instances use the following ones
+layout (std140) uniform DrawBlock
+{
+	DrawData draws[MAX_DRAWS];
+};
+uniform int baseDraw;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(inPosition, 1.0);
-	FragPos = vec3(model * vec4(inPosition, 1.0));
-	Normal = mat3(transpose(inverse(model))) * inNormal; // calculate the normal matrix
+	DrawData draw = draws[drawId >= 0 ? drawId : baseDraw + gl_InstanceID];
+	gl_Position = draw.mvp * vec4(inPosition, 1.0);
+	FragPos = vec3(draw.model * vec4(inPosition, 1.0));
+	Normal = mat3(draw.normalMatrix) * inNormal; // matrices are computed once per draw on the CPU
 	outColor = inColor;
 	uvOut = uvIn;
+	layer = draw.flags.y;
+	virtualTexture = draw.flags.z;
 }
@@ -0,0 +1,15 @@
+// Virtual texture lookups shared by test.frag and feedback.frag, see PageCache
+
+uniform vec4 virtualSize; // xy: texels of level 0, z: levels, w: slots per side of pageCache
+
+const float PageSize = 128.0; // PageFile::PageSize
+const float PageBorder = 4.0; // PageFile::Border
+
+// level of the virtual texture for the texel footprint, like the hardware picks a mip level
+float VirtualLevel(vec2 uv)
+{
+	vec2 texel = uv * virtualSize.xy;
+	vec2 dx = dFdx(texel);
+	vec2 dy = dFdy(texel);
+	return 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+}
@@ -0,0 +1,111 @@
+#include "BlockTexture.hpp"
+
+#include "GLState.hpp"
+#include "TextureStreamer.hpp"
+
+#include <GLFW/glfw3.h>
+
+//======================================================================================================================
+
+namespace
+{
+	// extension enums, the core loaders only define RGTC and BPTC (4.2+)
+	constexpr GLenum CompressedRgbS3tcDxt1 = 0x83F0;  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+	constexpr GLenum CompressedRgbaS3tcDxt5 = 0x83F3; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	constexpr GLenum CompressedRedRgtc1 = 0x8DBB;     // GL_COMPRESSED_RED_RGTC1
+	constexpr GLenum CompressedRgbaBptcUnorm = 0x8E8C; // GL_COMPRESSED_RGBA_BPTC_UNORM
+}
+
+//======================================================================================================================
+
+bool BlockTexture::IsSupported(BlockFormat const format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+	case BlockFormat::BC3:
+	{
+		static bool const s3tc = glfwExtensionSupported("GL_EXT_texture_compression_s3tc") == GLFW_TRUE;
+		return s3tc;
+	}
+	case BlockFormat::BC4:
+		return true;
+	case BlockFormat::BC7:
+	{
+#if defined(GL_VERSION_4_2)
+		if (GLAD_GL_VERSION_4_2)
+		{
+			return true;
+		}
+#endif
+		static bool const bptc = glfwExtensionSupported("GL_ARB_texture_compression_bptc") == GLFW_TRUE;
+		return bptc;
+	}
+	}
+	return false;
+}
+
+//======================================================================================================================
+
+GLenum BlockTexture::InternalFormat(BlockFormat const format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1: return CompressedRgbS3tcDxt1;
+	case BlockFormat::BC3: return CompressedRgbaS3tcDxt5;
+	case BlockFormat::BC4: return CompressedRedRgtc1;
+	case BlockFormat::BC7: return CompressedRgbaBptcUnorm;
+	}
+	return 0;
+}
+
+//======================================================================================================================
+
+void BlockTexture::AllocateStorage(GLenum const target, GLuint const texture, CompressedImage const& image, int const layers, GLint const interpolation)
+{
+	GLenum const internalFormat = InternalFormat(image.Format());
+	auto const& levels = image.Levels();
+
+	GLState::BindTexture(0, target, texture);
+	for (size_t level = 0; level < levels.size(); ++level)
+	{
+		auto const mip = static_cast<GLint>(level);
+		auto const size = static_cast<GLsizei>(levels[level].size);
+		if (target == GL_TEXTURE_2D_ARRAY)
+		{
+			glCompressedTexImage3D(target, mip, internalFormat, levels[level].width, levels[level].height, layers, 0, size * layers, nullptr);
+		}
+		else
+		{
+			glCompressedTexImage2D(target, mip, internalFormat, levels[level].width, levels[level].height, 0, size, nullptr);
+		}
+	}
+	TextureStreamer::SetFiltering(target, static_cast<int>(levels.size()), interpolation);
+	GLState::BindTexture(0, target, 0);
+}
+
+//======================================================================================================================
+
+void BlockTexture::Upload(GLenum const target, GLuint const texture, int const layer, CompressedImage const& image)
+{
+	GLenum const internalFormat = InternalFormat(image.Format());
+	auto const& levels = image.Levels();
+
+	GLState::BindTexture(0, target, texture);
+	for (size_t level = 0; level < levels.size(); ++level)
+	{
+		CompressedImage::Level const& mip = levels[level];
+		auto const size = static_cast<GLsizei>(mip.size);
+		if (target == GL_TEXTURE_2D_ARRAY)
+		{
+			glCompressedTexSubImage3D(target, static_cast<GLint>(level), 0, 0, layer, mip.width, mip.height, 1, internalFormat, size, mip.data);
+		}
+		else
+		{
+			glCompressedTexSubImage2D(target, static_cast<GLint>(level), 0, 0, mip.width, mip.height, internalFormat, size, mip.data);
+		}
+	}
+	GLState::BindTexture(0, target, 0);
+}
+
+//======================================================================================================================
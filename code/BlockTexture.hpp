@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CompressedImage.hpp"
+
+#include <glad/glad.h>
+
+// Uploads block-compressed images as they are, the GPU samples the blocks directly
+namespace BlockTexture
+{
+	// Whether the context can sample the format: BC1/BC3 need S3TC, BC4 is core, BC7 needs BPTC (core since 4.2)
+	[[nodiscard]]
+	bool IsSupported(BlockFormat format);
+
+	[[nodiscard]]
+	GLenum InternalFormat(BlockFormat format);
+
+	// Allocates every level of the image's size for GL_TEXTURE_2D, or layers of GL_TEXTURE_2D_ARRAY, and sets the
+	// filtering like TextureStreamer::AllocateStorage
+	void AllocateStorage(GLenum target, GLuint texture, CompressedImage const& image, int layers, GLint interpolation);
+
+	// Uploads every level of the image, into layer for GL_TEXTURE_2D_ARRAY
+	void Upload(GLenum target, GLuint texture, int layer, CompressedImage const& image);
+}
@@ -0,0 +1,476 @@
+#include "CompressedImage.hpp"
+
+#include "DiskCache.hpp"
+#include "Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+//======================================================================================================================
+
+namespace
+{
+	constexpr std::array<unsigned char, 12> Ktx2Identifier = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	constexpr size_t Ktx2HeaderSize = 80;
+	constexpr size_t Ktx2LevelIndexEntrySize = 24;
+
+	// VkFormat values, both variants are read as the same BlockFormat since the renderer samples the data like the
+	// source images. Images are written as UNORM unless the sRGB variant is asked for
+	constexpr uint32_t VkFormatBC1RgbUnorm = 131;
+	constexpr uint32_t VkFormatBC1RgbSrgb = 132;
+	constexpr uint32_t VkFormatBC1RgbaUnorm = 133;
+	constexpr uint32_t VkFormatBC1RgbaSrgb = 134;
+	constexpr uint32_t VkFormatBC3Unorm = 137;
+	constexpr uint32_t VkFormatBC3Srgb = 138;
+	constexpr uint32_t VkFormatBC4Unorm = 139;
+	constexpr uint32_t VkFormatBC7Unorm = 145;
+	constexpr uint32_t VkFormatBC7Srgb = 146;
+
+	// data format descriptor color models, khr_df.h
+	constexpr uint8_t DfModelBC1A = 128;
+	constexpr uint8_t DfModelBC3 = 130;
+	constexpr uint8_t DfModelBC4 = 131;
+	constexpr uint8_t DfModelBC7 = 134;
+
+	// data format descriptor transfer functions, khr_df.h
+	constexpr uint8_t DfTransferLinear = 1;
+	constexpr uint8_t DfTransferSrgb = 2;
+
+	constexpr size_t DdsHeaderSize = 124;
+	constexpr size_t DdsDx10HeaderSize = 20;
+
+	constexpr uint32_t FourCC(char const a, char const b, char const c, char const d)
+	{
+		return static_cast<uint32_t>(static_cast<unsigned char>(a))
+			| static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8
+			| static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16
+			| static_cast<uint32_t>(static_cast<unsigned char>(d)) << 24;
+	}
+
+	template <typename T>
+	T ReadValue(std::byte const* data)
+	{
+		T value{};
+		std::memcpy(&value, data, sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	void WriteValue(std::vector<std::byte>& bytes, size_t const offset, T const value)
+	{
+		std::memcpy(bytes.data() + offset, &value, sizeof(T));
+	}
+
+	//==================================================================================================================
+
+	bool IsKtx2(std::byte const* const data, size_t const available)
+	{
+		return available >= Ktx2Identifier.size() && std::memcmp(data, Ktx2Identifier.data(), Ktx2Identifier.size()) == 0;
+	}
+
+	// The parsers read the first available bytes of a file of fileSize bytes. Levels are only filled when data holds
+	// the whole file
+	bool ParseKtx2(
+		std::byte const* const data,
+		size_t const available,
+		size_t const fileSize,
+		CompressedImage::Info& info,
+		std::vector<CompressedImage::Level>* const levels
+	)
+	{
+		if (available < Ktx2HeaderSize)
+		{
+			return false;
+		}
+
+		uint32_t const vkFormat = ReadValue<uint32_t>(data + 12);
+		auto const width = static_cast<int>(ReadValue<uint32_t>(data + 20));
+		auto const height = static_cast<int>(ReadValue<uint32_t>(data + 24));
+		uint32_t const depth = ReadValue<uint32_t>(data + 28);
+		uint32_t const layerCount = ReadValue<uint32_t>(data + 32);
+		uint32_t const faceCount = ReadValue<uint32_t>(data + 36);
+		uint32_t const levelCount = std::max(ReadValue<uint32_t>(data + 40), 1u);
+		uint32_t const supercompression = ReadValue<uint32_t>(data + 44);
+		if (depth > 1 || layerCount > 1 || faceCount != 1 || supercompression != 0 || width <= 0 || height <= 0)
+		{
+			return false; // only plain 2d images
+		}
+
+		switch (vkFormat)
+		{
+		case VkFormatBC1RgbUnorm:
+		case VkFormatBC1RgbSrgb:
+		case VkFormatBC1RgbaUnorm:
+		case VkFormatBC1RgbaSrgb:
+			info.format = BlockFormat::BC1;
+			break;
+		case VkFormatBC3Unorm:
+		case VkFormatBC3Srgb:
+			info.format = BlockFormat::BC3;
+			break;
+		case VkFormatBC4Unorm:
+			info.format = BlockFormat::BC4;
+			break;
+		case VkFormatBC7Unorm:
+		case VkFormatBC7Srgb:
+			info.format = BlockFormat::BC7;
+			break;
+		default:
+			return false;
+		}
+
+		if (available < Ktx2HeaderSize + levelCount * Ktx2LevelIndexEntrySize)
+		{
+			return false;
+		}
+
+		int levelWidth = width;
+		int levelHeight = height;
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			std::byte const* entry = data + Ktx2HeaderSize + level * Ktx2LevelIndexEntrySize;
+			auto const offset = ReadValue<uint64_t>(entry);
+			auto const length = ReadValue<uint64_t>(entry + 8);
+			if (offset > fileSize || length > fileSize - offset || length != BlockFormats::LevelSize(info.format, levelWidth, levelHeight))
+			{
+				return false;
+			}
+
+			if (levels != nullptr)
+			{
+				levels->push_back({ levelWidth, levelHeight, data + offset, static_cast<size_t>(length) });
+			}
+			levelWidth = std::max(levelWidth / 2, 1);
+			levelHeight = std::max(levelHeight / 2, 1);
+		}
+
+		info.width = width;
+		info.height = height;
+		info.levelCount = static_cast<int>(levelCount);
+		return true;
+	}
+
+	//==================================================================================================================
+
+	bool ParseDds(
+		std::byte const* const data,
+		size_t const available,
+		size_t const fileSize,
+		CompressedImage::Info& info,
+		std::vector<CompressedImage::Level>* const levels
+	)
+	{
+		if (available < 4 + DdsHeaderSize || ReadValue<uint32_t>(data) != FourCC('D', 'D', 'S', ' '))
+		{
+			return false;
+		}
+
+		// offsets into DDS_HEADER after the magic number
+		std::byte const* header = data + 4;
+		auto const height = static_cast<int>(ReadValue<uint32_t>(header + 8));
+		auto const width = static_cast<int>(ReadValue<uint32_t>(header + 12));
+		uint32_t const levelCount = std::max(ReadValue<uint32_t>(header + 24), 1u);
+		uint32_t const fourCC = ReadValue<uint32_t>(header + 80);
+		size_t offset = 4 + DdsHeaderSize;
+		if (width <= 0 || height <= 0)
+		{
+			return false;
+		}
+
+		if (fourCC == FourCC('D', 'X', 'T', '1'))
+		{
+			info.format = BlockFormat::BC1;
+		}
+		else if (fourCC == FourCC('D', 'X', 'T', '5'))
+		{
+			info.format = BlockFormat::BC3;
+		}
+		else if (fourCC == FourCC('A', 'T', 'I', '1') || fourCC == FourCC('B', 'C', '4', 'U'))
+		{
+			info.format = BlockFormat::BC4;
+		}
+		else if (fourCC == FourCC('D', 'X', '1', '0'))
+		{
+			if (available < offset + DdsDx10HeaderSize)
+			{
+				return false;
+			}
+			switch (ReadValue<uint32_t>(data + offset)) // DXGI_FORMAT
+			{
+			case 71: case 72: info.format = BlockFormat::BC1; break;
+			case 77: case 78: info.format = BlockFormat::BC3; break;
+			case 80: info.format = BlockFormat::BC4; break;
+			case 98: case 99: info.format = BlockFormat::BC7; break;
+			default: return false;
+			}
+			uint32_t const arraySize = ReadValue<uint32_t>(data + offset + 12);
+			if (arraySize > 1)
+			{
+				return false;
+			}
+			offset += DdsDx10HeaderSize;
+		}
+		else
+		{
+			return false;
+		}
+
+		// levels follow each other largest first
+		int levelWidth = width;
+		int levelHeight = height;
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			size_t const size = BlockFormats::LevelSize(info.format, levelWidth, levelHeight);
+			if (size > fileSize - offset)
+			{
+				return false;
+			}
+
+			if (levels != nullptr)
+			{
+				levels->push_back({ levelWidth, levelHeight, data + offset, size });
+			}
+			offset += size;
+			levelWidth = std::max(levelWidth / 2, 1);
+			levelHeight = std::max(levelHeight / 2, 1);
+		}
+
+		info.width = width;
+		info.height = height;
+		info.levelCount = static_cast<int>(levelCount);
+		return true;
+	}
+}
+
+//======================================================================================================================
+
+size_t BlockFormats::BlockBytes(BlockFormat const format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+//======================================================================================================================
+
+char const* BlockFormats::Name(BlockFormat const format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1: return "BC1";
+	case BlockFormat::BC3: return "BC3";
+	case BlockFormat::BC4: return "BC4";
+	case BlockFormat::BC7: return "BC7";
+	}
+	return "?";
+}
+
+//======================================================================================================================
+
+size_t BlockFormats::LevelSize(BlockFormat const format, int const width, int const height)
+{
+	size_t const blocksWide = static_cast<size_t>(std::max((width + 3) / 4, 1));
+	size_t const blocksHigh = static_cast<size_t>(std::max((height + 3) / 4, 1));
+	return blocksWide * blocksHigh * BlockBytes(format);
+}
+
+//======================================================================================================================
+
+std::unique_ptr<CompressedImage> CompressedImage::Load(std::string const& path)
+{
+	MappedFile file(path);
+	if (file.IsValid() == false)
+	{
+		return nullptr;
+	}
+
+	std::unique_ptr<CompressedImage> image(new CompressedImage(std::move(file)));
+	std::byte const* const data = image->mFile.Data();
+	size_t const size = image->mFile.Size();
+	Info info{};
+	bool const parsed = IsKtx2(data, size)
+		? ParseKtx2(data, size, size, info, &image->mLevels)
+		: ParseDds(data, size, size, info, &image->mLevels);
+	if (parsed == false || image->mLevels.empty())
+	{
+		Log::warning("Unsupported or malformed compressed image {}", path);
+		return nullptr;
+	}
+	image->mFormat = info.format;
+	return image;
+}
+
+//======================================================================================================================
+
+std::optional<CompressedImage::Info> CompressedImage::Probe(std::string const& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::error_code error{};
+	auto const fileSize = static_cast<size_t>(std::filesystem::file_size(path, error));
+	if (file.is_open() == false || error)
+	{
+		return std::nullopt;
+	}
+
+	// enough for either header and the level index of any 2d image
+	std::array<std::byte, Ktx2HeaderSize + 32 * Ktx2LevelIndexEntrySize> header{};
+	file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+	auto const available = static_cast<size_t>(file.gcount());
+
+	Info info{};
+	bool const parsed = IsKtx2(header.data(), available)
+		? ParseKtx2(header.data(), available, fileSize, info, nullptr)
+		: ParseDds(header.data(), available, fileSize, info, nullptr);
+	if (parsed == false)
+	{
+		Log::warning("Unsupported or malformed compressed image {}", path);
+		return std::nullopt;
+	}
+	return info;
+}
+
+//======================================================================================================================
+
+std::string CompressedImage::PathFor(std::string const& imagePath)
+{
+	std::filesystem::path const source(imagePath);
+	std::filesystem::path const directory = source.parent_path() / "compressed";
+	for (char const* extension : { ".ktx2", ".dds" })
+	{
+		std::filesystem::path candidate = directory / source.stem();
+		candidate += extension;
+		std::error_code error{};
+		if (std::filesystem::exists(candidate, error))
+		{
+			return candidate.string();
+		}
+	}
+	return {};
+}
+
+//======================================================================================================================
+
+size_t CompressedImage::Size() const
+{
+	size_t size = 0;
+	for (Level const& level : mLevels)
+	{
+		size += level.size;
+	}
+	return size;
+}
+
+//======================================================================================================================
+
+bool Ktx2::Write(
+	std::filesystem::path const& path,
+	BlockFormat const format,
+	int const width,
+	int const height,
+	std::vector<std::vector<std::byte>> const& levels,
+	bool const srgb
+)
+{
+	struct Sample
+	{
+		uint16_t bitOffset;
+		uint8_t bitLength; // minus one
+		uint8_t channel;
+	};
+
+	uint32_t vkFormat = srgb ? VkFormatBC1RgbSrgb : VkFormatBC1RgbUnorm;
+	uint8_t colorModel = DfModelBC1A;
+	std::array<Sample, 2> samples{};
+	size_t sampleCount = 1;
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		samples[0] = { 0, 63, 0 }; // color
+		break;
+	case BlockFormat::BC3:
+		vkFormat = srgb ? VkFormatBC3Srgb : VkFormatBC3Unorm;
+		colorModel = DfModelBC3;
+		samples = { Sample{ 0, 63, 15 }, Sample{ 64, 63, 0 } }; // alpha, color
+		sampleCount = 2;
+		break;
+	case BlockFormat::BC4:
+		vkFormat = VkFormatBC4Unorm;
+		colorModel = DfModelBC4;
+		samples[0] = { 0, 63, 0 }; // data
+		break;
+	case BlockFormat::BC7:
+		vkFormat = srgb ? VkFormatBC7Srgb : VkFormatBC7Unorm;
+		colorModel = DfModelBC7;
+		samples[0] = { 0, 127, 0 }; // color
+		break;
+	}
+
+	// the transfer function has to agree with the VkFormat
+	bool const srgbFormat = vkFormat == VkFormatBC1RgbSrgb || vkFormat == VkFormatBC3Srgb || vkFormat == VkFormatBC7Srgb;
+
+	size_t const levelCount = levels.size();
+	size_t const dfdOffset = Ktx2HeaderSize + levelCount * Ktx2LevelIndexEntrySize;
+	size_t const dfdBlockSize = 24 + 16 * sampleCount;
+	size_t const dfdSize = 4 + dfdBlockSize;
+
+	// levels are stored smallest first, each aligned to its block size
+	constexpr size_t Alignment = 16;
+	std::vector<size_t> levelOffsets(levelCount);
+	size_t size = dfdOffset + dfdSize;
+	for (size_t level = levelCount; level-- > 0;)
+	{
+		size = (size + Alignment - 1) / Alignment * Alignment;
+		levelOffsets[level] = size;
+		size += levels[level].size();
+	}
+
+	std::vector<std::byte> bytes(size);
+	std::memcpy(bytes.data(), Ktx2Identifier.data(), Ktx2Identifier.size());
+	WriteValue<uint32_t>(bytes, 12, vkFormat);
+	WriteValue<uint32_t>(bytes, 16, 1); // typeSize
+	WriteValue<uint32_t>(bytes, 20, static_cast<uint32_t>(width));
+	WriteValue<uint32_t>(bytes, 24, static_cast<uint32_t>(height));
+	WriteValue<uint32_t>(bytes, 28, 0); // pixelDepth
+	WriteValue<uint32_t>(bytes, 32, 0); // layerCount
+	WriteValue<uint32_t>(bytes, 36, 1); // faceCount
+	WriteValue<uint32_t>(bytes, 40, static_cast<uint32_t>(levelCount));
+	WriteValue<uint32_t>(bytes, 44, 0); // supercompressionScheme
+	WriteValue<uint32_t>(bytes, 48, static_cast<uint32_t>(dfdOffset));
+	WriteValue<uint32_t>(bytes, 52, static_cast<uint32_t>(dfdSize));
+	// no key/value data and no supercompression global data, their offsets and lengths stay 0
+
+	for (size_t level = 0; level < levelCount; ++level)
+	{
+		size_t const entry = Ktx2HeaderSize + level * Ktx2LevelIndexEntrySize;
+		WriteValue<uint64_t>(bytes, entry, levelOffsets[level]);
+		WriteValue<uint64_t>(bytes, entry + 8, levels[level].size());
+		WriteValue<uint64_t>(bytes, entry + 16, levels[level].size());
+		std::memcpy(bytes.data() + levelOffsets[level], levels[level].data(), levels[level].size());
+	}
+
+	// basic data format descriptor block
+	size_t const dfd = dfdOffset;
+	WriteValue<uint32_t>(bytes, dfd, static_cast<uint32_t>(dfdSize));
+	WriteValue<uint32_t>(bytes, dfd + 4, 0); // vendorId and descriptorType: Khronos basic
+	WriteValue<uint32_t>(bytes, dfd + 8, 2u | static_cast<uint32_t>(dfdBlockSize) << 16); // versionNumber, descriptorBlockSize
+	WriteValue<uint8_t>(bytes, dfd + 12, colorModel);
+	WriteValue<uint8_t>(bytes, dfd + 13, 1); // BT.709 primaries
+	WriteValue<uint8_t>(bytes, dfd + 14, srgbFormat ? DfTransferSrgb : DfTransferLinear);
+	WriteValue<uint8_t>(bytes, dfd + 15, 0); // straight alpha
+	WriteValue<uint32_t>(bytes, dfd + 16, 3u | 3u << 8); // 4x4 texel blocks, stored minus one
+	WriteValue<uint8_t>(bytes, dfd + 20, static_cast<uint8_t>(BlockFormats::BlockBytes(format))); // bytesPlane0
+	for (size_t i = 0; i < sampleCount; ++i)
+	{
+		size_t const sample = dfd + 28 + i * 16;
+		WriteValue<uint16_t>(bytes, sample, samples[i].bitOffset);
+		WriteValue<uint8_t>(bytes, sample + 2, samples[i].bitLength);
+		WriteValue<uint8_t>(bytes, sample + 3, samples[i].channel);
+		WriteValue<uint32_t>(bytes, sample + 8, 0); // sampleLower
+		WriteValue<uint32_t>(bytes, sample + 12, 0xFFFFFFFFu); // sampleUpper
+	}
+
+	return DiskCache::WriteFile(path, bytes.data(), bytes.size());
+}
+
+//======================================================================================================================
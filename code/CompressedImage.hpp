@@ -0,0 +1,109 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Block-compressed formats of 4x4 texel blocks
+enum class BlockFormat : uint32_t
+{
+	BC1, // rgb, 8 bytes per block
+	BC3, // rgba, bc1 color and bc4 alpha, 16 bytes per block
+	BC4, // single channel, 8 bytes per block
+	BC7, // rgba, 16 bytes per block
+};
+
+namespace BlockFormats
+{
+	[[nodiscard]]
+	size_t BlockBytes(BlockFormat format);
+
+	[[nodiscard]]
+	char const* Name(BlockFormat format);
+
+	// Bytes of a level, partial blocks at the edges count as whole blocks
+	[[nodiscard]]
+	size_t LevelSize(BlockFormat format, int width, int height);
+}
+
+// Block-compressed image with its mip levels, read from a KTX2 or DDS file. The levels point into the mapped file, so
+// they can be uploaded without copying
+class CompressedImage
+{
+public:
+
+	struct Level
+	{
+		int width = 0;
+		int height = 0;
+		std::byte const* data = nullptr;
+		size_t size = 0;
+	};
+
+	// What the header of a file describes
+	struct Info
+	{
+		BlockFormat format = BlockFormat::BC1;
+		int width = 0;
+		int height = 0;
+		int levelCount = 0;
+	};
+
+	// Returns null if the file is missing, malformed or in a format other than BlockFormat
+	[[nodiscard]]
+	static std::unique_ptr<CompressedImage> Load(std::string const& path);
+
+	// Reads only the header and level index and checks that the levels fit in the file, without mapping it. Empty
+	// where Load would return null
+	[[nodiscard]]
+	static std::optional<Info> Probe(std::string const& path);
+
+	// The compressed file made for a source image, textures/compressed/<name>.ktx2 or .dds. Empty if there is none
+	[[nodiscard]]
+	static std::string PathFor(std::string const& imagePath);
+
+	[[nodiscard]]
+	BlockFormat Format() const { return mFormat; }
+
+	[[nodiscard]]
+	int Width() const { return mLevels.front().width; }
+
+	[[nodiscard]]
+	int Height() const { return mLevels.front().height; }
+
+	[[nodiscard]]
+	std::vector<Level> const& Levels() const { return mLevels; }
+
+	// Bytes of all levels
+	[[nodiscard]]
+	size_t Size() const;
+
+private:
+
+	explicit CompressedImage(MappedFile file) : mFile(std::move(file)) {}
+
+	MappedFile mFile;
+	BlockFormat mFormat = BlockFormat::BC1;
+	std::vector<Level> mLevels{};
+};
+
+// Khronos KTX 2.0 container, https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+namespace Ktx2
+{
+	// Writes a 2D image with the given levels, largest first, and no supercompression. srgb labels the color formats
+	// with their sRGB VkFormat and transfer function, BC4 has no sRGB variant and stays linear
+	bool Write(
+		std::filesystem::path const& path,
+		BlockFormat format,
+		int width,
+		int height,
+		std::vector<std::vector<std::byte>> const& levels,
+		bool srgb = false
+	);
+}
@@ -0,0 +1,104 @@
+#include "DiskCache.hpp"
+
+#include "Log.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace DiskCache
+{
+
+	//==================================================================================================================
+
+	std::filesystem::path Directory(char const* category)
+	{
+		std::filesystem::path directory = std::filesystem::current_path() / "cache" / category;
+		std::error_code error{};
+		std::filesystem::create_directories(directory, error);
+		if (error)
+		{
+			Log::warning("Failed to create cache directory {}: {}", directory.string(), error.message());
+		}
+		return directory;
+	}
+
+	//==================================================================================================================
+
+	uint64_t Hash(void const* data, size_t const size, uint64_t seed)
+	{
+		auto const* bytes = static_cast<unsigned char const*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			seed ^= bytes[i];
+			seed *= 1099511628211ull; // FNV-1a prime
+		}
+		return seed;
+	}
+
+	//==================================================================================================================
+
+	uint64_t Hash(std::string const& text, uint64_t const seed)
+	{
+		return Hash(text.data(), text.size(), seed);
+	}
+
+	//==================================================================================================================
+
+	uint64_t HashFile(std::string const& path)
+	{
+		MappedFile const file(path);
+		if (file.IsValid() == false)
+		{
+			return 0;
+		}
+		return Hash(file.Data(), file.Size());
+	}
+
+	//==================================================================================================================
+
+	bool WriteFile(std::filesystem::path const& path, void const* data, size_t const size)
+	{
+		return WriteFile(path, { Part{ data, size } });
+	}
+
+	//==================================================================================================================
+
+	bool WriteFile(std::filesystem::path const& path, std::initializer_list<Part> const parts)
+	{
+		// the thread tells writers apart, the counter the calls of one thread
+		static std::atomic<uint64_t> writeCount{ 0 };
+		size_t const thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += '.' + std::to_string(thread) + '.' + std::to_string(writeCount++) + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			for (Part const& part : parts)
+			{
+				if (!file.write(static_cast<char const*>(part.data), static_cast<std::streamsize>(part.size)))
+				{
+					Log::warning("Failed to write cache file {}", temporaryPath.string());
+					file.close();
+					std::error_code error{};
+					std::filesystem::remove(temporaryPath, error);
+					return false;
+				}
+			}
+		}
+
+		std::error_code error{};
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			Log::warning("Failed to move cache file into place {}: {}", path.string(), error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	//==================================================================================================================
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+
+// Helpers shared by the on-disk caches (generated geometry, decoded textures, ...).
+// Cache files live under ./cache/<category> relative to the working directory and can be deleted at any time.
+namespace DiskCache
+{
+	inline static constexpr uint64_t HashSeed = 14695981039346656037ull; // FNV-1a offset basis
+
+	// Returns the directory for the given category, creating it if needed
+	[[nodiscard]]
+	std::filesystem::path Directory(char const* category);
+
+	// FNV-1a, chain calls by passing the previous result as seed
+	[[nodiscard]]
+	uint64_t Hash(void const* data, size_t size, uint64_t seed = HashSeed);
+
+	[[nodiscard]]
+	uint64_t Hash(std::string const& text, uint64_t seed = HashSeed);
+
+	// Hash of the contents of a file, 0 if it cannot be read
+	[[nodiscard]]
+	uint64_t HashFile(std::string const& path);
+
+	// Bytes of a file written in parts
+	struct Part
+	{
+		void const* data = nullptr;
+		size_t size = 0;
+	};
+
+	// Writes to a temporary file first and renames it, so readers never see a partially written entry. The temporary
+	// name is unique per call, so threads storing the same entry at once never write into each other's file
+	bool WriteFile(std::filesystem::path const& path, void const* data, size_t size);
+
+	// Same, writes the parts one after the other without joining them in memory first
+	bool WriteFile(std::filesystem::path const& path, std::initializer_list<Part> parts);
+}
@@ -0,0 +1,97 @@
+#include "DrawData.hpp"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define DRAW_DATA_SSE 1
+#include <xmmintrin.h>
+#endif
+
+//======================================================================================================================
+
+DrawData DrawBlock::Make(glm::mat4 const& model, int const layer, int const virtualTexture)
+{
+	DrawData data{};
+	data.model = model;
+	data.flags = glm::ivec4(0, layer, virtualTexture, 0);
+	return data;
+}
+
+//======================================================================================================================
+
+#if defined(DRAW_DATA_SSE)
+
+// (y, z, x, w) of a vector
+static __m128 YZX(__m128 const v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+//======================================================================================================================
+
+// cross product of the xyz components
+static __m128 Cross(__m128 const a, __m128 const b)
+{
+	__m128 const c = _mm_sub_ps(_mm_mul_ps(a, YZX(b)), _mm_mul_ps(YZX(a), b));
+	return YZX(c);
+}
+
+//======================================================================================================================
+
+void DrawBlock::ComputeMatrices(glm::mat4 const& viewProjection, DrawData* const draws, size_t const count)
+{
+	// glm matrices are column major, so every column of a product is a sum of the left matrix's columns
+	__m128 const vp0 = _mm_loadu_ps(&viewProjection[0][0]);
+	__m128 const vp1 = _mm_loadu_ps(&viewProjection[1][0]);
+	__m128 const vp2 = _mm_loadu_ps(&viewProjection[2][0]);
+	__m128 const vp3 = _mm_loadu_ps(&viewProjection[3][0]);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		glm::mat4 const& model = draws[i].model;
+		__m128 columns[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			columns[c] = _mm_loadu_ps(&model[c][0]);
+			__m128 mvp = _mm_mul_ps(vp0, _mm_set1_ps(model[c][0]));
+			mvp = _mm_add_ps(mvp, _mm_mul_ps(vp1, _mm_set1_ps(model[c][1])));
+			mvp = _mm_add_ps(mvp, _mm_mul_ps(vp2, _mm_set1_ps(model[c][2])));
+			mvp = _mm_add_ps(mvp, _mm_mul_ps(vp3, _mm_set1_ps(model[c][3])));
+			_mm_storeu_ps(&draws[i].mvp[c][0], mvp);
+		}
+
+		// the inverse transpose of the upper 3x3 is its cofactor matrix over the determinant
+		// cofactor columns are cross products of the model's columns. The w of a cross product is 0 whatever w the
+		// columns carry, which also keeps w out of the determinant
+		__m128 const n0 = Cross(columns[1], columns[2]);
+		__m128 const n1 = Cross(columns[2], columns[0]);
+		__m128 const n2 = Cross(columns[0], columns[1]);
+
+		float determinant = 0.0f;
+		__m128 const product = _mm_mul_ps(columns[0], n0);
+		__m128 const sum = _mm_add_ps(product, _mm_movehl_ps(product, product));
+		_mm_store_ss(&determinant, _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+		__m128 const inverseDeterminant = _mm_set1_ps(1.0f / determinant);
+
+		glm::mat4& normalMatrix = draws[i].normalMatrix;
+		_mm_storeu_ps(&normalMatrix[0][0], _mm_mul_ps(n0, inverseDeterminant));
+		_mm_storeu_ps(&normalMatrix[1][0], _mm_mul_ps(n1, inverseDeterminant));
+		_mm_storeu_ps(&normalMatrix[2][0], _mm_mul_ps(n2, inverseDeterminant));
+		normalMatrix[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+#else
+
+void DrawBlock::ComputeMatrices(glm::mat4 const& viewProjection, DrawData* const draws, size_t const count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		draws[i].mvp = viewProjection * draws[i].model;
+		draws[i].normalMatrix = glm::mat4(glm::inverseTranspose(glm::mat3(draws[i].model)));
+	}
+}
+
+#endif
+
+//======================================================================================================================
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-draw data streamed to the shaders through the DrawBlock uniform block.
+// Layout follows std140 and must match DrawData in test.vert
+struct DrawData
+{
+	glm::mat4 mvp{};          // projection * view * model
+	glm::mat4 model{};
+	glm::mat4 normalMatrix{}; // only the upper 3x3 is used, a mat4 keeps the std140 layout trivial
+	glm::ivec4 flags{};       // x: unused, y: layer in the body texture array or -1, z: virtual texture id in the
+	                          // PageCache or -1
+};
+
+namespace DrawBlock
+{
+	inline static constexpr char const* Name = "DrawBlock";
+	inline static constexpr uint32_t Binding = 0;
+	inline static constexpr uint32_t MaxDraws = 64; // per bound block, keep in sync with MAX_DRAWS in test.vert
+	inline static constexpr uint32_t Blocks = 4; // blocks per frame, each draw binds the block with its entry
+	inline static constexpr uint32_t MaxFrameDraws = MaxDraws * Blocks; // further draws of a frame are dropped
+	inline static constexpr uint32_t DrawIdLocation = 4; // instanced attribute used by indirect draws, see MeshPool
+
+	// Fills model and flags, the matrices derived from the model are left to ComputeMatrices
+	[[nodiscard]]
+	DrawData Make(glm::mat4 const& model, int layer = -1, int virtualTexture = -1);
+
+	// Computes mvp and normalMatrix of every draw in one pass over the frame's draws, with SSE where available
+	void ComputeMatrices(glm::mat4 const& viewProjection, DrawData* draws, size_t count);
+}
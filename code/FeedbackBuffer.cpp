@@ -0,0 +1,129 @@
+#include "FeedbackBuffer.hpp"
+
+#include "GLState.hpp"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+//======================================================================================================================
+
+FeedbackBuffer::~FeedbackBuffer()
+{
+	for (Readback const& readback : mReadbacks)
+	{
+		if (readback.fence != nullptr)
+		{
+			glDeleteSync(readback.fence);
+		}
+	}
+}
+
+//======================================================================================================================
+
+void FeedbackBuffer::Resize(int const width, int const height)
+{
+	mWidth = width;
+	mHeight = height;
+
+	GLState::BindTexture(0, GL_TEXTURE_2D, mTarget);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, mWidth, mHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GLState::BindTexture(0, GL_TEXTURE_2D, 0);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, mDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mWidth, mHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTarget, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		Log::error("Feedback framebuffer is incomplete");
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+//======================================================================================================================
+
+void FeedbackBuffer::Begin(int const windowWidth, int const windowHeight)
+{
+	mWindowWidth = windowWidth;
+	mWindowHeight = windowHeight;
+	int const width = std::max(windowWidth / Scale, 1);
+	int const height = std::max(windowHeight / Scale, 1);
+	if (width != mWidth || height != mHeight)
+	{
+		Resize(width, height);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glViewport(0, 0, mWidth, mHeight);
+	GLuint const empty[4] = { Empty, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, empty);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+//======================================================================================================================
+
+void FeedbackBuffer::End()
+{
+	Readback& readback = mReadbacks[mNext];
+	mNext = (mNext + 1) % FramesInFlight;
+	if (readback.fence != nullptr)
+	{
+		// never read, newer feedback replaces it
+		glDeleteSync(readback.fence);
+	}
+
+	readback.texelCount = static_cast<size_t>(mWidth) * static_cast<size_t>(mHeight);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(readback.texelCount * sizeof(uint32_t)), nullptr, GL_STREAM_READ);
+	glReadPixels(0, 0, mWidth, mHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr); // into the buffer, returns right away
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, mWindowWidth, mWindowHeight);
+}
+
+//======================================================================================================================
+
+bool FeedbackBuffer::Read(std::vector<uint32_t>& texels)
+{
+	for (size_t i = 0; i < FramesInFlight; ++i)
+	{
+		Readback& readback = mReadbacks[(mNext + i) % FramesInFlight];
+		if (readback.fence == nullptr)
+		{
+			continue;
+		}
+
+		// the oldest one decides, a newer one can't have finished before it
+		GLenum const result = glClientWaitSync(readback.fence, 0, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+		{
+			return false;
+		}
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+
+		size_t const size = readback.texelCount * sizeof(uint32_t);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		void const* const data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT);
+		bool const mapped = data != nullptr;
+		if (mapped)
+		{
+			texels.resize(readback.texelCount);
+			std::memcpy(texels.data(), data, size);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		return mapped;
+	}
+	return false;
+}
+
+//======================================================================================================================
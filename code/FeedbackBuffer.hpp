@@ -0,0 +1,61 @@
+#pragma once
+
+#include "GLHandles.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Small integer render target the feedback shader writes the virtual texture page of every visible texel into. The
+// target is read back through pixel buffers a few frames later, so the CPU never waits on the GPU for it.
+//
+// Usage per frame: Begin() -> draw with the feedback shader -> End(), then Read() whenever convenient
+class FeedbackBuffer
+{
+public:
+
+	static constexpr int Scale = 8; // the target is 1/Scale of the window on each side
+	static constexpr size_t FramesInFlight = 3;
+	static constexpr GLuint Empty = 0xFFFFFFFFu; // texels without a virtual texture
+
+	FeedbackBuffer() = default;
+
+	~FeedbackBuffer();
+
+	FeedbackBuffer(FeedbackBuffer const&) = delete;
+	FeedbackBuffer& operator=(FeedbackBuffer const&) = delete;
+
+	// Binds the target sized for the window and clears it to Empty
+	void Begin(int windowWidth, int windowHeight);
+
+	// Queues the readback of the target, then binds the default framebuffer and viewport again
+	void End();
+
+	// Copies the oldest readback that arrived into texels, false if none did
+	bool Read(std::vector<uint32_t>& texels);
+
+private:
+
+	struct Readback
+	{
+		VertexBufferHandle buffer{};
+		GLsync fence = nullptr;
+		size_t texelCount = 0;
+	};
+
+	void Resize(int width, int height);
+
+	FramebufferHandle mFramebuffer{};
+	TextureHandle mTarget{};
+	RenderbufferHandle mDepth{};
+	int mWidth = 0;
+	int mHeight = 0;
+	int mWindowWidth = 0;
+	int mWindowHeight = 0;
+
+	std::array<Readback, FramesInFlight> mReadbacks{};
+	size_t mNext = 0; // readback written by the next End()
+};
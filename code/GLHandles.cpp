@@ -1,5 +1,7 @@
 #include "GLHandles.h"
 
+#include "GLState.hpp"
+
 #include <algorithm> // For std::swap
 
 ShaderHandle::ShaderHandle(GLenum type)
@@ -58,6 +60,7 @@ ShaderProgramHandle& ShaderProgramHandle::operator=(ShaderProgramHandle&& other)
 
 
 ShaderProgramHandle::~ShaderProgramHandle() {
+	GLState::ForgetProgram(programID);
 	glDeleteProgram(programID);
 }
 
@@ -95,6 +98,7 @@ VertexArrayHandle& VertexArrayHandle::operator=(VertexArrayHandle&& other) noexc
 
 
 VertexArrayHandle::~VertexArrayHandle() {
+	GLState::ForgetVertexArray(vaoID);
 	glDeleteVertexArrays(1, &vaoID);
 }
 
@@ -168,6 +172,7 @@ TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
 
 
 TextureHandle::~TextureHandle() {
+	GLState::ForgetTexture(textureID);
 	glDeleteTextures(1, &textureID);
 }
 
@@ -180,3 +185,75 @@ TextureHandle::operator GLuint() const {
 GLuint TextureHandle::value() const {
 	return textureID;
 }
+
+
+//------------------------------------------------------------------------------
+
+FramebufferHandle::FramebufferHandle()
+	: framebufferID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::FramebufferHandle(FramebufferHandle&& other) noexcept
+	: framebufferID(std::move(other.framebufferID))
+{
+	other.framebufferID = 0;
+}
+
+FramebufferHandle& FramebufferHandle::operator=(FramebufferHandle&& other) noexcept {
+	std::swap(framebufferID, other.framebufferID);
+	return *this;
+}
+
+
+FramebufferHandle::~FramebufferHandle() {
+	glDeleteFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::operator GLuint() const {
+	return framebufferID;
+}
+
+
+GLuint FramebufferHandle::value() const {
+	return framebufferID;
+}
+
+
+//------------------------------------------------------------------------------
+
+RenderbufferHandle::RenderbufferHandle()
+	: renderbufferID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenRenderbuffers(1, &renderbufferID);
+}
+
+
+RenderbufferHandle::RenderbufferHandle(RenderbufferHandle&& other) noexcept
+	: renderbufferID(std::move(other.renderbufferID))
+{
+	other.renderbufferID = 0;
+}
+
+RenderbufferHandle& RenderbufferHandle::operator=(RenderbufferHandle&& other) noexcept {
+	std::swap(renderbufferID, other.renderbufferID);
+	return *this;
+}
+
+
+RenderbufferHandle::~RenderbufferHandle() {
+	glDeleteRenderbuffers(1, &renderbufferID);
+}
+
+
+RenderbufferHandle::operator GLuint() const {
+	return renderbufferID;
+}
+
+
+GLuint RenderbufferHandle::value() const {
+	return renderbufferID;
+}
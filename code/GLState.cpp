@@ -0,0 +1,268 @@
+#include "GLState.hpp"
+
+#include <iterator>
+#include <limits>
+
+//======================================================================================================================
+
+namespace
+{
+	constexpr GLuint Unknown = std::numeric_limits<GLuint>::max();
+
+	constexpr size_t MaxTextureUnits = 8;
+
+	// texture targets in use, others are passed through
+	constexpr GLenum TextureTargets[] { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP };
+	constexpr size_t TextureTargetCount = std::size(TextureTargets);
+
+	constexpr GLenum Capabilities[] { GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST };
+	constexpr size_t CapabilityCount = std::size(Capabilities);
+
+	struct State
+	{
+		GLuint program = Unknown;
+		GLuint vertexArray = Unknown;
+		GLuint activeTexture = Unknown;
+		GLuint textures[MaxTextureUnits][TextureTargetCount]{};
+		GLuint capabilities[CapabilityCount]{}; // 0, 1 or Unknown
+		GLenum blendSource = Unknown;
+		GLenum blendDestination = Unknown;
+		GLenum cullFace = Unknown;
+		GLenum frontFace = Unknown;
+		GLenum depthFunc = Unknown;
+		GLuint depthMask = Unknown;
+
+		State()
+		{
+			for (auto& unit : textures)
+			{
+				for (GLuint& texture : unit)
+				{
+					texture = Unknown;
+				}
+			}
+			for (GLuint& capability : capabilities)
+			{
+				capability = Unknown;
+			}
+		}
+	};
+
+	State state{};
+	GLState::Counters current{};
+	GLState::Counters last{};
+
+	// returns true if the call has to reach the driver and updates the counters
+	bool Change(GLState::Call const call, GLuint& cached, GLuint const value)
+	{
+		auto const index = static_cast<size_t>(call);
+		if (cached == value)
+		{
+			++current.avoided[index];
+			return false;
+		}
+		cached = value;
+		++current.issued[index];
+		return true;
+	}
+
+	template<size_t N>
+	size_t IndexOf(GLenum const (&values)[N], GLenum const value)
+	{
+		for (size_t i = 0; i < N; ++i)
+		{
+			if (values[i] == value)
+			{
+				return i;
+			}
+		}
+		return N;
+	}
+}
+
+//======================================================================================================================
+
+void GLState::UseProgram(GLuint const program)
+{
+	if (Change(Call::UseProgram, state.program, program))
+	{
+		glUseProgram(program);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::BindVertexArray(GLuint const vertexArray)
+{
+	if (Change(Call::BindVertexArray, state.vertexArray, vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::BindTexture(GLuint const unit, GLenum const target, GLuint const texture)
+{
+	size_t const targetIndex = IndexOf(TextureTargets, target);
+	if (unit >= MaxTextureUnits || targetIndex == TextureTargetCount)
+	{
+		state.activeTexture = Unknown;
+		++current.issued[static_cast<size_t>(Call::ActiveTexture)];
+		++current.issued[static_cast<size_t>(Call::BindTexture)];
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	GLuint& cached = state.textures[unit][targetIndex];
+	if (cached == texture)
+	{
+		++current.avoided[static_cast<size_t>(Call::BindTexture)];
+		return;
+	}
+
+	if (Change(Call::ActiveTexture, state.activeTexture, unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	Change(Call::BindTexture, cached, texture);
+	glBindTexture(target, texture);
+}
+
+//======================================================================================================================
+
+void GLState::Enable(GLenum const capability)
+{
+	size_t const index = IndexOf(Capabilities, capability);
+	if (index == CapabilityCount || Change(Call::Capability, state.capabilities[index], 1))
+	{
+		glEnable(capability);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::Disable(GLenum const capability)
+{
+	size_t const index = IndexOf(Capabilities, capability);
+	if (index == CapabilityCount || Change(Call::Capability, state.capabilities[index], 0))
+	{
+		glDisable(capability);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::BlendFunc(GLenum const source, GLenum const destination)
+{
+	if (state.blendSource == source && state.blendDestination == destination)
+	{
+		++current.avoided[static_cast<size_t>(Call::BlendFunc)];
+		return;
+	}
+	state.blendSource = source;
+	state.blendDestination = destination;
+	++current.issued[static_cast<size_t>(Call::BlendFunc)];
+	glBlendFunc(source, destination);
+}
+
+//======================================================================================================================
+
+void GLState::CullFace(GLenum const mode)
+{
+	if (Change(Call::CullFace, state.cullFace, mode))
+	{
+		glCullFace(mode);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::FrontFace(GLenum const mode)
+{
+	if (Change(Call::FrontFace, state.frontFace, mode))
+	{
+		glFrontFace(mode);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::DepthFunc(GLenum const function)
+{
+	if (Change(Call::DepthFunc, state.depthFunc, function))
+	{
+		glDepthFunc(function);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::DepthMask(bool const write)
+{
+	if (Change(Call::DepthMask, state.depthMask, write ? 1 : 0))
+	{
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+}
+
+//======================================================================================================================
+
+void GLState::ForgetProgram(GLuint const program)
+{
+	if (state.program == program)
+	{
+		state.program = Unknown;
+	}
+}
+
+//======================================================================================================================
+
+void GLState::ForgetVertexArray(GLuint const vertexArray)
+{
+	if (state.vertexArray == vertexArray)
+	{
+		state.vertexArray = Unknown;
+	}
+}
+
+//======================================================================================================================
+
+void GLState::ForgetTexture(GLuint const texture)
+{
+	for (auto& unit : state.textures)
+	{
+		for (GLuint& cached : unit)
+		{
+			if (cached == texture)
+			{
+				cached = Unknown;
+			}
+		}
+	}
+}
+
+//======================================================================================================================
+
+void GLState::Invalidate()
+{
+	state = State{};
+}
+
+//======================================================================================================================
+
+GLState::Counters const& GLState::LastFrame()
+{
+	return last;
+}
+
+//======================================================================================================================
+
+void GLState::EndFrame()
+{
+	last = current;
+	current = Counters{};
+}
+
+//======================================================================================================================
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Cache of the GL state the renderer changes, calls that would not change anything are skipped.
+// Every change of the tracked state has to go through here. ImGui restores whatever it touches, so the cache stays
+// valid across its draws, call Invalidate after any other code changed tracked state directly
+namespace GLState
+{
+	enum class Call
+	{
+		UseProgram,
+		BindVertexArray,
+		ActiveTexture,
+		BindTexture,
+		Capability,
+		BlendFunc,
+		CullFace,
+		FrontFace,
+		DepthFunc,
+		DepthMask,
+		Count
+	};
+
+	inline static constexpr char const* CallNames[static_cast<size_t>(Call::Count)]
+	{
+		"UseProgram", "BindVertexArray", "ActiveTexture", "BindTexture", "Enable/Disable", "BlendFunc", "CullFace",
+		"FrontFace", "DepthFunc", "DepthMask"
+	};
+
+	struct Counters
+	{
+		std::array<uint32_t, static_cast<size_t>(Call::Count)> issued{};
+		std::array<uint32_t, static_cast<size_t>(Call::Count)> avoided{};
+	};
+
+	void UseProgram(GLuint program);
+
+	void BindVertexArray(GLuint vertexArray);
+
+	// Binds to a texture unit (index, not GL_TEXTUREi), the active unit is only switched when the binding changes
+	void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+	// GL_BLEND, GL_CULL_FACE and GL_DEPTH_TEST are cached, other capabilities are passed through
+	void Enable(GLenum capability);
+
+	void Disable(GLenum capability);
+
+	void BlendFunc(GLenum source, GLenum destination);
+
+	void CullFace(GLenum mode);
+
+	void FrontFace(GLenum mode);
+
+	void DepthFunc(GLenum function);
+
+	void DepthMask(bool write);
+
+	// Called when objects are deleted, the name may be reused by a new object that then has to be bound again
+	void ForgetProgram(GLuint program);
+
+	void ForgetVertexArray(GLuint vertexArray);
+
+	void ForgetTexture(GLuint texture);
+
+	// Forgets everything, the next call of each kind reaches the driver
+	void Invalidate();
+
+	// Counters of the last completed frame
+	[[nodiscard]]
+	Counters const& LastFrame();
+
+	void EndFrame();
+}
@@ -8,6 +8,7 @@ GPU_Geometry::GPU_Geometry()
 	, colorsBuffer(1, sizeof(Color) / sizeof(float), GL_FLOAT)
 	, normalsBuffer(2, sizeof(Normal) / sizeof(float), GL_FLOAT)
 	, uvsBuffer(3, sizeof(UV) / sizeof(float), GL_FLOAT)
+	, indexBuffer()
 {
 }
 
@@ -33,10 +34,12 @@ void GPU_Geometry::UpdateUVs(size_t const count, UV const* uvs)
 	uvsBuffer.uploadData(sizeof(UV) * count, uvs, GL_STATIC_DRAW);
 }
 
-// void GPU_Geometry::UpdateIndices(size_t const count, Index const *indices)
-// {
-// TODO
-// }
+void GPU_Geometry::UpdateIndices(size_t const count, Index const* indices)
+{
+	// the element buffer binding is part of the vao state, make sure we don't change another vao
+	vao.bind();
+	indexBuffer.uploadData(sizeof(Index) * count, indices, GL_STATIC_DRAW);
+}
 
 //======================================================================================================================
 
@@ -51,7 +54,16 @@ void GPU_Geometry::Update(CPU_Geometry const& data)
 	UpdateColors(data.colors.size(), data.colors.data());
 	UpdateNormals(data.normals.size(), data.normals.data());
 	UpdateUVs(data.uvs.size(), data.uvs.data());
-	// UpdateIndices(data.indices.size(), data.indices.data());
+	UpdateIndices(data.indices.size(), data.indices.data());
+}
+
+void GPU_Geometry::Update(CPU_GeometryView const& data)
+{
+	UpdatePositions(data.vertexCount, data.positions);
+	UpdateColors(data.vertexCount, data.colors);
+	UpdateNormals(data.vertexCount, data.normals);
+	UpdateUVs(data.vertexCount, data.uvs);
+	UpdateIndices(data.indexCount, data.indices);
 }
 
 //======================================================================================================================
@@ -25,7 +25,19 @@ struct CPU_Geometry {
 	std::vector<Color> colors;
 	std::vector<Normal> normals;
 	std::vector<UV> uvs;             // You need the uv for texture mapping
-	// std::vector<Index> indices;      // Index buffer (EBO) is needed for the bonuses
+	std::vector<Index> indices;      // Index buffer (EBO), empty for non-indexed geometry
+};
+
+// Non-owning view of vertex arrays, used to upload geometry that does not live in a CPU_Geometry
+// (e.g. a memory-mapped cache file)
+struct CPU_GeometryView {
+	size_t vertexCount = 0;
+	Position const* positions = nullptr;
+	Color const* colors = nullptr;
+	Normal const* normals = nullptr;
+	UV const* uvs = nullptr;
+	size_t indexCount = 0;
+	Index const* indices = nullptr;
 };
 
 
@@ -49,12 +61,14 @@ private:
 
 	void UpdateUVs(size_t count, UV const* uvs);
 
-	// void UpdateIndices(size_t count, Index const * indices);
+	void UpdateIndices(size_t count, Index const* indices);
 
 public:
 
 	void Update(CPU_Geometry const& data);
 
+	void Update(CPU_GeometryView const& data);
+
 private:
 	// note: due to how OpenGL works, vao needs to be
 		// defined and initialized before the vertex buffers
@@ -65,7 +79,7 @@ private:
 	VertexBuffer normalsBuffer;
 	VertexBuffer uvsBuffer;
 
-	// IndexBuffer indexBuffer;
+	IndexBuffer indexBuffer;
 
 private:
 
@@ -0,0 +1,170 @@
+#include "GeometryCache.hpp"
+
+#include "DiskCache.hpp"
+#include "Log.h"
+#include "MappedFile.h"
+
+#include <cstring>
+
+namespace GeometryCache
+{
+
+	//==================================================================================================================
+
+	static constexpr uint32_t Magic = 0x4D4F4547; // "GEOM"
+	static constexpr size_t ArrayAlignment = 16;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t keyHash;
+		uint64_t vertexCount;
+		uint64_t positionsOffset;
+		uint64_t colorsOffset;
+		uint64_t normalsOffset;
+		uint64_t uvsOffset;
+		uint64_t indexCount;
+		uint64_t indicesOffset;
+		uint64_t meshletCount;
+		uint64_t meshletsOffset;
+		uint64_t fileSize;
+	};
+
+	//==================================================================================================================
+
+	static uint64_t HashKey(Key const& key, bool const clustered)
+	{
+		uint64_t hash = DiskCache::Hash(&Version, sizeof(Version));
+		hash = DiskCache::Hash(key.generator, hash);
+		hash = DiskCache::Hash(key.parameters.data(), key.parameters.size() * sizeof(float), hash);
+		hash = DiskCache::Hash(&key.source, sizeof(key.source), hash);
+		return DiskCache::Hash(&clustered, sizeof(clustered), hash);
+	}
+
+	//==================================================================================================================
+
+	static size_t Align(size_t const offset)
+	{
+		return (offset + ArrayAlignment - 1) & ~(ArrayAlignment - 1);
+	}
+
+	//==================================================================================================================
+
+	static Header MakeHeader(uint64_t const keyHash, size_t const vertexCount, size_t const indexCount, size_t const meshletCount)
+	{
+		Header header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.keyHash = keyHash;
+		header.vertexCount = vertexCount;
+		header.positionsOffset = Align(sizeof(Header));
+		header.colorsOffset = Align(header.positionsOffset + vertexCount * sizeof(Position));
+		header.normalsOffset = Align(header.colorsOffset + vertexCount * sizeof(Color));
+		header.uvsOffset = Align(header.normalsOffset + vertexCount * sizeof(Normal));
+		header.indexCount = indexCount;
+		header.indicesOffset = Align(header.uvsOffset + vertexCount * sizeof(UV));
+		header.meshletCount = meshletCount;
+		header.meshletsOffset = Align(header.indicesOffset + indexCount * sizeof(Index));
+		header.fileSize = header.meshletsOffset + meshletCount * sizeof(Meshlet);
+		return header;
+	}
+
+	//==================================================================================================================
+
+	static bool IsValid(MappedFile const& file, uint64_t const keyHash)
+	{
+		if (file.IsValid() == false || file.Size() < sizeof(Header))
+		{
+			return false;
+		}
+
+		Header header{};
+		std::memcpy(&header, file.Data(), sizeof(Header));
+		if (header.magic != Magic || header.version != Version || header.keyHash != keyHash)
+		{
+			return false;
+		}
+
+		// offsets are derived from the counts, so a matching header guarantees the arrays are where we expect
+		Header const expected = MakeHeader(keyHash, header.vertexCount, header.indexCount, header.meshletCount);
+		return std::memcmp(&header, &expected, sizeof(Header)) == 0 && file.Size() >= header.fileSize;
+	}
+
+	//==================================================================================================================
+
+	static void Store(
+		std::filesystem::path const& path,
+		uint64_t const keyHash,
+		CPU_Geometry const& geometry,
+		std::vector<Meshlet> const& meshlets
+	)
+	{
+		size_t const vertexCount = geometry.positions.size();
+		if (geometry.colors.size() != vertexCount || geometry.normals.size() != vertexCount || geometry.uvs.size() != vertexCount)
+		{
+			Log::warning("Geometry cache skipped {}, vertex arrays have different sizes", path.string());
+			return;
+		}
+
+		Header const header = MakeHeader(keyHash, vertexCount, geometry.indices.size(), meshlets.size());
+		std::vector<std::byte> blob(header.fileSize);
+		std::memcpy(blob.data(), &header, sizeof(Header));
+		std::memcpy(blob.data() + header.positionsOffset, geometry.positions.data(), vertexCount * sizeof(Position));
+		std::memcpy(blob.data() + header.colorsOffset, geometry.colors.data(), vertexCount * sizeof(Color));
+		std::memcpy(blob.data() + header.normalsOffset, geometry.normals.data(), vertexCount * sizeof(Normal));
+		std::memcpy(blob.data() + header.uvsOffset, geometry.uvs.data(), vertexCount * sizeof(UV));
+		std::memcpy(blob.data() + header.indicesOffset, geometry.indices.data(), geometry.indices.size() * sizeof(Index));
+		std::memcpy(blob.data() + header.meshletsOffset, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+
+		DiskCache::WriteFile(path, blob.data(), blob.size());
+	}
+
+	//==================================================================================================================
+
+	Entry Load(Key const& key, std::function<CPU_Geometry()> const& generate, bool const clustered)
+	{
+		uint64_t const keyHash = HashKey(key, clustered);
+		auto const path = DiskCache::Directory("geometry") / fmt::format("{}_{:016x}.geom", key.generator, keyHash);
+
+		Entry entry{};
+		auto file = std::make_shared<MappedFile>(path.string());
+		if (IsValid(*file, keyHash))
+		{
+			Header header{};
+			std::memcpy(&header, file->Data(), sizeof(Header));
+
+			entry.view.vertexCount = header.vertexCount;
+			entry.view.positions = reinterpret_cast<Position const*>(file->Data() + header.positionsOffset);
+			entry.view.colors = reinterpret_cast<Color const*>(file->Data() + header.colorsOffset);
+			entry.view.normals = reinterpret_cast<Normal const*>(file->Data() + header.normalsOffset);
+			entry.view.uvs = reinterpret_cast<UV const*>(file->Data() + header.uvsOffset);
+			entry.view.indexCount = header.indexCount;
+			entry.view.indices = reinterpret_cast<Index const*>(file->Data() + header.indicesOffset);
+			// meshlets are few, copied since Meshlets::Cull works on a vector
+			entry.meshlets.resize(header.meshletCount);
+			std::memcpy(entry.meshlets.data(), file->Data() + header.meshletsOffset, header.meshletCount * sizeof(Meshlet));
+			entry.file = std::move(file);
+			return entry;
+		}
+
+		entry.generated = generate();
+		if (clustered)
+		{
+			CPU_Geometry& generated = entry.generated;
+			std::vector<Index> clusteredIndices{};
+			entry.meshlets = Meshlets::Build(generated.positions.data(), generated.positions.size(), generated.indices.data(),
+				generated.indices.size(), clusteredIndices);
+			generated.indices = std::move(clusteredIndices);
+		}
+		Store(path, keyHash, entry.generated, entry.meshlets);
+		CPU_Geometry const& geometry = entry.generated;
+		entry.view = { geometry.positions.size(), geometry.positions.data(), geometry.colors.data(), geometry.normals.data(),
+			geometry.uvs.data(), geometry.indices.size(), geometry.indices.data() };
+		return entry;
+	}
+
+
+	//==================================================================================================================
+
+}
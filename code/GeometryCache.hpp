@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Geometry.h"
+#include "MappedFile.h"
+#include "Meshlet.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Versioned binary cache for generated or imported geometry.
+// Each entry is keyed by the generator name, the parameters passed to it and the file it reads, if any. Later runs
+// memory-map the file and upload the vertex arrays straight into the GPU buffers without touching individual vertices.
+// Clustered entries also keep their meshlets, so they are only built on the run that fills the entry.
+namespace GeometryCache
+{
+	// Bump whenever the file layout or the output of any generator changes
+	inline static constexpr uint32_t Version = 3;
+
+	struct Key
+	{
+		std::string generator{};
+		std::vector<float> parameters{};
+		uint64_t source = 0; // DiskCache::HashFile of the file generate() reads, so an edited file misses
+	};
+
+	// Geometry of an entry, the arrays of view point into the mapped cache file or into the geometry just generated
+	struct Entry
+	{
+		CPU_GeometryView view{};
+		std::shared_ptr<MappedFile const> file{}; // keeps mapped arrays alive
+		CPU_Geometry generated{}; // on a miss
+		std::vector<Meshlet> meshlets{}; // of clustered entries, their indices are in meshlet order
+
+		// The index count, or the vertex count if not indexed
+		[[nodiscard]]
+		int ElementCount() const { return static_cast<int>(view.indexCount > 0 ? view.indexCount : view.vertexCount); }
+	};
+
+	// The cached geometry for key. On a miss generate() is called and its geometry stored for the next run, clustered
+	// first groups its triangles with Meshlets::Build
+	[[nodiscard]]
+	Entry Load(Key const& key, std::function<CPU_Geometry()> const& generate, bool clustered = false);
+}
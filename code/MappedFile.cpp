@@ -0,0 +1,132 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//======================================================================================================================
+
+MappedFile::MappedFile(std::string const& path)
+{
+#if defined(_WIN32)
+	HANDLE const file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	mFileHandle = file;
+
+	LARGE_INTEGER size{};
+	if (GetFileSizeEx(file, &size) == FALSE || size.QuadPart == 0)
+	{
+		Close();
+		return;
+	}
+
+	HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		return;
+	}
+	mMappingHandle = mapping;
+
+	void* const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		Close();
+		return;
+	}
+	mData = static_cast<std::byte const*>(view);
+	mSize = static_cast<size_t>(size.QuadPart);
+#else
+	int const file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return;
+	}
+
+	struct stat status{};
+	if (fstat(file, &status) != 0 || status.st_size <= 0)
+	{
+		close(file);
+		return;
+	}
+
+	void* const view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file); // the mapping keeps its own reference to the file
+	if (view == MAP_FAILED)
+	{
+		return;
+	}
+	mData = static_cast<std::byte const*>(view);
+	mSize = static_cast<size_t>(status.st_size);
+#endif
+}
+
+//======================================================================================================================
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//======================================================================================================================
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+//======================================================================================================================
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	std::swap(mData, other.mData);
+	std::swap(mSize, other.mSize);
+#if defined(_WIN32)
+	std::swap(mFileHandle, other.mFileHandle);
+	std::swap(mMappingHandle, other.mMappingHandle);
+#endif
+	return *this;
+}
+
+//======================================================================================================================
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (mData != nullptr)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMappingHandle != nullptr)
+	{
+		CloseHandle(mMappingHandle);
+	}
+	if (mFileHandle != nullptr)
+	{
+		CloseHandle(mFileHandle);
+	}
+	mMappingHandle = nullptr;
+	mFileHandle = nullptr;
+#else
+	if (mData != nullptr)
+	{
+		munmap(const_cast<std::byte*>(mData), mSize);
+	}
+#endif
+	mData = nullptr;
+	mSize = 0;
+}
+
+//======================================================================================================================
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file mapped into memory.
+// The mapping lives as long as the object; an empty object is returned if the file cannot be opened.
+class MappedFile
+{
+public:
+
+	explicit MappedFile(std::string const& path);
+
+	~MappedFile();
+
+	// Disallow copying
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	// Allow moving
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	[[nodiscard]]
+	bool IsValid() const { return mData != nullptr; }
+
+	[[nodiscard]]
+	std::byte const* Data() const { return mData; }
+
+	[[nodiscard]]
+	size_t Size() const { return mSize; }
+
+private:
+
+	void Close();
+
+	std::byte const* mData = nullptr;
+	size_t mSize = 0;
+
+#if defined(_WIN32)
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+#endif
+};
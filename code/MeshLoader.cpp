@@ -0,0 +1,877 @@
+#include "MeshLoader.hpp"
+
+#include "MappedFile.h"
+#include "ShapeGenerator.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+//======================================================================================================================
+
+namespace
+{
+
+	// Fills in the attributes a file did not provide, so the result is always drawable
+	void CompleteAttributes(CPU_Geometry& geometry, bool const hasNormals, bool const hasUVs)
+	{
+		size_t const vertexCount = geometry.positions.size();
+		geometry.colors.assign(vertexCount, ShapeGenerator::DefaultColor);
+
+		if (hasNormals == false)
+		{
+			// area weighted face normals accumulated per vertex
+			geometry.normals.assign(vertexCount, Normal{ 0.0f });
+			for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3)
+			{
+				Index const a = geometry.indices[i];
+				Index const b = geometry.indices[i + 1];
+				Index const c = geometry.indices[i + 2];
+				Normal const faceNormal = glm::cross(geometry.positions[b] - geometry.positions[a], geometry.positions[c] - geometry.positions[a]);
+				geometry.normals[a] += faceNormal;
+				geometry.normals[b] += faceNormal;
+				geometry.normals[c] += faceNormal;
+			}
+			for (Normal& normal : geometry.normals)
+			{
+				float const length = glm::length(normal);
+				normal = length > 0.0f ? normal / length : Normal{ 0.0f, 1.0f, 0.0f };
+			}
+		}
+
+		if (hasUVs == false)
+		{
+			// equirectangular projection around the bounding box center, matches how the sphere uvs are laid out
+			glm::vec3 minimum{ std::numeric_limits<float>::max() };
+			glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+			for (Position const& position : geometry.positions)
+			{
+				minimum = glm::min(minimum, position);
+				maximum = glm::max(maximum, position);
+			}
+			glm::vec3 const center = (minimum + maximum) * 0.5f;
+
+			geometry.uvs.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				glm::vec3 const direction = geometry.positions[i] - center;
+				float const length = glm::length(direction);
+				float const u = std::atan2(direction.z, direction.x) / glm::two_pi<float>();
+				float const v = length > 0.0f ? std::asin(glm::clamp(direction.y / length, -1.0f, 1.0f)) / glm::pi<float>() : 0.0f;
+				geometry.uvs[i] = UV{ u < 0.0f ? u + 1.0f : u, v + 0.5f };
+			}
+		}
+	}
+
+	//==================================================================================================================
+
+	// std::from_chars for floating point numbers. Standard libraries without it (Apple libc++) fall back to strtof and
+	// strtod on a terminated copy of the number, which unlike from_chars depend on the C locale
+	template<typename T>
+	std::from_chars_result ParseFloat(char const* const first, char const* const last, T& value)
+	{
+#if defined(__cpp_lib_to_chars)
+		return std::from_chars(first, last, value);
+#else
+		char buffer[64]{};
+		size_t const length = std::min(static_cast<size_t>(last - first), sizeof(buffer) - 1);
+		std::memcpy(buffer, first, length);
+		if (length == 0 || std::isspace(static_cast<unsigned char>(buffer[0])) || buffer[0] == '+')
+		{
+			return { first, std::errc::invalid_argument }; // both are skipped by strtod but rejected by from_chars
+		}
+
+		char* end = nullptr;
+		errno = 0;
+		if constexpr (std::is_same_v<T, float>)
+		{
+			value = std::strtof(buffer, &end);
+		}
+		else
+		{
+			value = std::strtod(buffer, &end);
+		}
+		if (end == buffer)
+		{
+			return { first, std::errc::invalid_argument };
+		}
+		return { first + (end - buffer), errno == ERANGE ? std::errc::result_out_of_range : std::errc() };
+#endif
+	}
+
+	//==================================================================================================================
+	// OBJ
+	//==================================================================================================================
+
+	class ObjCursor
+	{
+	public:
+
+		ObjCursor(char const* begin, char const* end) : mCurrent(begin), mEnd(end) {}
+
+		[[nodiscard]]
+		bool AtEnd() const { return mCurrent >= mEnd; }
+
+		[[nodiscard]]
+		bool AtLineEnd() const { return mCurrent >= mEnd || *mCurrent == '\n' || *mCurrent == '\r' || *mCurrent == '#'; }
+
+		[[nodiscard]]
+		char Peek() const { return *mCurrent; }
+
+		void Advance() { ++mCurrent; }
+
+		void SkipSpaces()
+		{
+			while (mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\t'))
+			{
+				++mCurrent;
+			}
+		}
+
+		void SkipLine()
+		{
+			while (mCurrent < mEnd && *mCurrent != '\n')
+			{
+				++mCurrent;
+			}
+			if (mCurrent < mEnd)
+			{
+				++mCurrent;
+			}
+		}
+
+		// Returns the record keyword ("v", "vt", "f", ...) without allocating
+		[[nodiscard]]
+		std::string_view Keyword()
+		{
+			SkipSpaces();
+			char const* start = mCurrent;
+			while (mCurrent < mEnd && *mCurrent != ' ' && *mCurrent != '\t' && *mCurrent != '\n' && *mCurrent != '\r')
+			{
+				++mCurrent;
+			}
+			return std::string_view(start, static_cast<size_t>(mCurrent - start));
+		}
+
+		float Float()
+		{
+			SkipSpaces();
+			float value = 0.0f;
+			if (mCurrent < mEnd && *mCurrent == '+')
+			{
+				++mCurrent; // from_chars does not accept a leading plus
+			}
+			auto const result = ParseFloat(mCurrent, mEnd, value);
+			if (result.ec != std::errc())
+			{
+				throw std::runtime_error("Malformed number in OBJ file");
+			}
+			mCurrent = result.ptr;
+			return value;
+		}
+
+		// Returns false if there is no integer at the cursor
+		bool Int(long& value)
+		{
+			auto const result = std::from_chars(mCurrent, mEnd, value);
+			if (result.ec != std::errc())
+			{
+				return false;
+			}
+			mCurrent = result.ptr;
+			return true;
+		}
+
+	private:
+
+		char const* mCurrent;
+		char const* mEnd;
+	};
+
+	struct ObjCorner
+	{
+		long position = 0;
+		long uv = 0;
+		long normal = 0;
+
+		bool operator==(ObjCorner const& other) const
+		{
+			return position == other.position && uv == other.uv && normal == other.normal;
+		}
+	};
+
+	struct ObjCornerHash
+	{
+		size_t operator()(ObjCorner const& corner) const
+		{
+			size_t hash = static_cast<size_t>(corner.position) * 73856093u;
+			hash ^= static_cast<size_t>(corner.uv) * 19349663u;
+			hash ^= static_cast<size_t>(corner.normal) * 83492791u;
+			return hash;
+		}
+	};
+
+	// OBJ indices are 1 based and negative values count back from the end
+	long ResolveObjIndex(long const index, size_t const count)
+	{
+		long const resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+		if (resolved < 0 || resolved >= static_cast<long>(count))
+		{
+			throw std::runtime_error("OBJ face references a missing vertex");
+		}
+		return resolved;
+	}
+
+	//==================================================================================================================
+	// GLB
+	//==================================================================================================================
+
+	// Just enough JSON to read the glTF scene description
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		double number = 0.0;
+		std::string string{};
+		std::vector<JsonValue> elements{}; // array elements or object values
+		std::vector<std::string> keys{};   // object keys, parallel to elements
+
+		[[nodiscard]]
+		JsonValue const* Find(std::string_view const key) const
+		{
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				if (keys[i] == key)
+				{
+					return &elements[i];
+				}
+			}
+			return nullptr;
+		}
+
+		[[nodiscard]]
+		JsonValue const* At(size_t const index) const
+		{
+			return type == Type::Array && index < elements.size() ? &elements[index] : nullptr;
+		}
+
+		[[nodiscard]]
+		double NumberOr(std::string_view const key, double const fallback) const
+		{
+			JsonValue const* value = Find(key);
+			return value != nullptr && value->type == Type::Number ? value->number : fallback;
+		}
+
+		// The value of key as an index or a size, empty when it is missing, negative, fractional or beyond what a
+		// double holds exactly
+		[[nodiscard]]
+		std::optional<size_t> Size(std::string_view const key) const
+		{
+			constexpr double MaxExact = 9007199254740992.0; // 2^53
+			double const number = NumberOr(key, -1.0);
+			if (number >= 0.0 && number <= MaxExact && std::floor(number) == number)
+			{
+				return static_cast<size_t>(number);
+			}
+			return std::nullopt;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+
+		// glTF nests a few levels, anything deeper is malformed and would only run the recursion out of stack
+		static constexpr int MaxDepth = 64;
+
+		JsonParser(char const* begin, char const* end) : mCurrent(begin), mEnd(end) {}
+
+		JsonValue Parse()
+		{
+			return Parse(0);
+		}
+
+	private:
+
+		JsonValue Parse(int const depth)
+		{
+			if (depth > MaxDepth)
+			{
+				throw std::runtime_error("glTF JSON is nested too deep");
+			}
+			SkipSpaces();
+			JsonValue value{};
+			if (mCurrent >= mEnd)
+			{
+				throw std::runtime_error("Unexpected end of glTF JSON");
+			}
+
+			switch (*mCurrent)
+			{
+			case '{':
+				value.type = JsonValue::Type::Object;
+				++mCurrent;
+				while (Consume('}') == false)
+				{
+					Consume(',');
+					SkipSpaces();
+					value.keys.emplace_back(String());
+					SkipSpaces();
+					Expect(':');
+					value.elements.emplace_back(Parse(depth + 1));
+					SkipSpaces();
+				}
+				break;
+			case '[':
+				value.type = JsonValue::Type::Array;
+				++mCurrent;
+				while (Consume(']') == false)
+				{
+					Consume(',');
+					value.elements.emplace_back(Parse(depth + 1));
+					SkipSpaces();
+				}
+				break;
+			case '"':
+				value.type = JsonValue::Type::String;
+				value.string = String();
+				break;
+			case 't':
+			case 'f':
+			case 'n':
+				value.type = *mCurrent == 'n' ? JsonValue::Type::Null : JsonValue::Type::Bool;
+				value.number = *mCurrent == 't' ? 1.0 : 0.0;
+				while (mCurrent < mEnd && std::isalpha(static_cast<unsigned char>(*mCurrent)))
+				{
+					++mCurrent;
+				}
+				break;
+			default:
+			{
+				value.type = JsonValue::Type::Number;
+				auto const result = ParseFloat(mCurrent, mEnd, value.number);
+				if (result.ec != std::errc())
+				{
+					throw std::runtime_error("Malformed glTF JSON");
+				}
+				mCurrent = result.ptr;
+				break;
+			}
+			}
+			return value;
+		}
+
+		void SkipSpaces()
+		{
+			while (mCurrent < mEnd && std::isspace(static_cast<unsigned char>(*mCurrent)))
+			{
+				++mCurrent;
+			}
+		}
+
+		bool Consume(char const character)
+		{
+			SkipSpaces();
+			if (mCurrent < mEnd && *mCurrent == character)
+			{
+				++mCurrent;
+				return true;
+			}
+			if (mCurrent >= mEnd)
+			{
+				throw std::runtime_error("Unexpected end of glTF JSON");
+			}
+			return false;
+		}
+
+		void Expect(char const character)
+		{
+			if (Consume(character) == false)
+			{
+				throw std::runtime_error("Malformed glTF JSON");
+			}
+		}
+
+		// glTF keys and the values we read never use escapes beyond \" and \\, keep the escaped character as is
+		std::string String()
+		{
+			Expect('"');
+			std::string result{};
+			while (mCurrent < mEnd && *mCurrent != '"')
+			{
+				if (*mCurrent == '\\' && mCurrent + 1 < mEnd)
+				{
+					++mCurrent;
+				}
+				result.push_back(*mCurrent++);
+			}
+			Expect('"');
+			return result;
+		}
+
+		char const* mCurrent;
+		char const* mEnd;
+	};
+
+	constexpr uint32_t GlbMagic = 0x46546C67; // "glTF"
+	constexpr uint32_t GlbChunkJson = 0x4E4F534A; // "JSON"
+	constexpr uint32_t GlbChunkBin = 0x004E4942; // "BIN\0"
+
+	constexpr int ComponentUnsignedByte = 5121;
+	constexpr int ComponentUnsignedShort = 5123;
+	constexpr int ComponentUnsignedInt = 5125;
+	constexpr int ComponentFloat = 5126;
+	constexpr int ModeTriangles = 4;
+
+	uint32_t ReadU32(std::byte const* data)
+	{
+		uint32_t value = 0;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	// Strided view of the elements of one accessor inside the binary chunk
+	struct GlbAccessor
+	{
+		std::byte const* data = nullptr;
+		size_t count = 0;
+		size_t stride = 0;
+		int componentType = 0;
+		int componentCount = 0;
+	};
+
+	GlbAccessor ResolveAccessor(JsonValue const& document, size_t const accessorIndex, std::byte const* bin, size_t const binSize)
+	{
+		JsonValue const* accessors = document.Find("accessors");
+		JsonValue const* accessor = accessors != nullptr ? accessors->At(accessorIndex) : nullptr;
+		if (accessor == nullptr)
+		{
+			throw std::runtime_error("glTF references a missing accessor");
+		}
+
+		JsonValue const* bufferViews = document.Find("bufferViews");
+		std::optional<size_t> const viewIndex = accessor->Size("bufferView");
+		JsonValue const* view = bufferViews != nullptr && viewIndex.has_value() ? bufferViews->At(*viewIndex) : nullptr;
+		if (view == nullptr || view->NumberOr("buffer", 0.0) != 0.0)
+		{
+			throw std::runtime_error("glTF accessor must reference the GLB binary chunk");
+		}
+
+		GlbAccessor result{};
+		result.count = accessor->Size("count").value_or(0);
+		size_t const componentType = accessor->Size("componentType").value_or(0);
+		result.componentType = componentType <= ComponentFloat ? static_cast<int>(componentType) : 0; // 0 is unsupported
+
+		JsonValue const* type = accessor->Find("type");
+		std::string const typeName = type != nullptr ? type->string : std::string{};
+		result.componentCount = typeName == "VEC2" ? 2 : typeName == "VEC3" ? 3 : typeName == "VEC4" ? 4 : 1;
+
+		size_t const componentSize = result.componentType == ComponentUnsignedByte ? 1 : result.componentType == ComponentUnsignedShort ? 2 : 4;
+		size_t const elementSize = componentSize * static_cast<size_t>(result.componentCount);
+		result.stride = view->Size("byteStride").value_or(elementSize);
+
+		// below 2^53 each, the sums cannot overflow, the last element is bounded by dividing instead of multiplying
+		size_t const viewOffset = view->Size("byteOffset").value_or(0);
+		size_t const offset = viewOffset + accessor->Size("byteOffset").value_or(0);
+		size_t const viewEnd = viewOffset + view->Size("byteLength").value_or(0);
+		if (result.count > 0 && (viewEnd > binSize || offset > viewEnd || elementSize > viewEnd - offset
+			|| result.count - 1 > (viewEnd - offset - elementSize) / std::max<size_t>(result.stride, 1)))
+		{
+			throw std::runtime_error("glTF accessor is out of bounds");
+		}
+		result.data = bin + offset;
+		return result;
+	}
+
+	template <typename T>
+	void ReadFloats(GlbAccessor const& accessor, std::vector<T>& output)
+	{
+		constexpr int componentCount = static_cast<int>(sizeof(T) / sizeof(float));
+		if (accessor.componentType != ComponentFloat || accessor.componentCount != componentCount)
+		{
+			throw std::runtime_error("Unsupported glTF vertex attribute format");
+		}
+
+		size_t const start = output.size();
+		output.resize(start + accessor.count);
+		for (size_t i = 0; i < accessor.count; i++)
+		{
+			std::memcpy(&output[start + i], accessor.data + i * accessor.stride, sizeof(T));
+		}
+	}
+
+}
+
+//======================================================================================================================
+
+CPU_Geometry MeshLoader::Load(std::string const& path)
+{
+	MappedFile const file(path);
+	if (file.IsValid() == false)
+	{
+		throw std::runtime_error("Failed to open mesh " + path);
+	}
+
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char const c) { return static_cast<char>(std::tolower(c)); });
+
+	if (extension == ".obj")
+	{
+		return ParseOBJ(reinterpret_cast<char const*>(file.Data()), file.Size());
+	}
+	if (extension == ".glb")
+	{
+		return ParseGLB(file.Data(), file.Size());
+	}
+	throw std::runtime_error("Unsupported mesh format " + path);
+}
+
+//======================================================================================================================
+
+CPU_Geometry MeshLoader::ParseOBJ(char const* data, size_t const size)
+{
+	std::vector<Position> positions{};
+	std::vector<UV> uvs{};
+	std::vector<Normal> normals{};
+
+	// shape models are mostly "v" and "f" records, a rough guess avoids most of the regrowth
+	positions.reserve(size / 64);
+
+	CPU_Geometry geometry{};
+	geometry.indices.reserve(size / 16);
+
+	// only needed once a face references uvs or normals, otherwise the position index is the vertex index
+	std::unordered_map<ObjCorner, Index, ObjCornerHash> cornerToVertex{};
+	bool positionsOnly = true;
+	bool sawFaces = false;
+
+	ObjCursor cursor(data, data + size);
+	while (cursor.AtEnd() == false)
+	{
+		std::string_view const keyword = cursor.Keyword();
+		if (keyword == "v")
+		{
+			float const x = cursor.Float();
+			float const y = cursor.Float();
+			float const z = cursor.Float();
+			positions.emplace_back(x, y, z);
+		}
+		else if (keyword == "vt")
+		{
+			// v is optional like w and defaults to 0
+			float const u = cursor.Float();
+			cursor.SkipSpaces();
+			float const v = cursor.AtLineEnd() ? 0.0f : cursor.Float();
+			uvs.emplace_back(u, v);
+		}
+		else if (keyword == "vn")
+		{
+			float const x = cursor.Float();
+			float const y = cursor.Float();
+			float const z = cursor.Float();
+			normals.emplace_back(x, y, z);
+		}
+		else if (keyword == "f")
+		{
+			Index first = 0;
+			Index previous = 0;
+			int cornerCount = 0;
+
+			cursor.SkipSpaces();
+			while (cursor.AtLineEnd() == false)
+			{
+				ObjCorner corner{};
+				if (cursor.Int(corner.position) == false)
+				{
+					throw std::runtime_error("Malformed face in OBJ file");
+				}
+				corner.position = ResolveObjIndex(corner.position, positions.size()) + 1;
+				if (cursor.AtEnd() == false && cursor.Peek() == '/')
+				{
+					cursor.Advance();
+					if (cursor.Int(corner.uv)) // "v//vn" has no uv
+					{
+						corner.uv = ResolveObjIndex(corner.uv, uvs.size()) + 1;
+					}
+					if (cursor.AtEnd() == false && cursor.Peek() == '/')
+					{
+						cursor.Advance();
+						if (cursor.Int(corner.normal))
+						{
+							corner.normal = ResolveObjIndex(corner.normal, normals.size()) + 1;
+						}
+					}
+				}
+
+				if ((corner.uv != 0 || corner.normal != 0) && positionsOnly)
+				{
+					if (sawFaces)
+					{
+						throw std::runtime_error("OBJ files mixing faces with and without uvs/normals are not supported");
+					}
+					positionsOnly = false;
+				}
+
+				Index vertex = static_cast<Index>(corner.position - 1);
+				if (positionsOnly == false)
+				{
+					auto const [iterator, inserted] = cornerToVertex.try_emplace(corner, static_cast<Index>(geometry.positions.size()));
+					if (inserted)
+					{
+						geometry.positions.push_back(positions[corner.position - 1]);
+						geometry.uvs.push_back(corner.uv != 0 ? uvs[corner.uv - 1] : UV{ 0.0f });
+						geometry.normals.push_back(corner.normal != 0 ? normals[corner.normal - 1] : Normal{ 0.0f });
+					}
+					vertex = iterator->second;
+				}
+
+				// fan triangulation of polygons
+				if (cornerCount == 0)
+				{
+					first = vertex;
+				}
+				else if (cornerCount >= 2)
+				{
+					geometry.indices.push_back(first);
+					geometry.indices.push_back(previous);
+					geometry.indices.push_back(vertex);
+				}
+				previous = vertex;
+				cornerCount++;
+				cursor.SkipSpaces();
+			}
+			sawFaces = true;
+		}
+		cursor.SkipLine();
+	}
+
+	if (geometry.indices.empty())
+	{
+		throw std::runtime_error("OBJ file has no faces");
+	}
+
+	bool hasUVs = false;
+	bool hasNormals = false;
+	if (positionsOnly)
+	{
+		geometry.positions = std::move(positions);
+	}
+	else
+	{
+		hasUVs = uvs.empty() == false;
+		hasNormals = normals.empty() == false;
+	}
+	CompleteAttributes(geometry, hasNormals, hasUVs);
+	return geometry;
+}
+
+//======================================================================================================================
+
+CPU_Geometry MeshLoader::ParseGLB(std::byte const* data, size_t const size)
+{
+	if (size < 20 || ReadU32(data) != GlbMagic || ReadU32(data + 4) != 2)
+	{
+		throw std::runtime_error("Not a glTF 2.0 binary file");
+	}
+
+	// chunks follow the 12 byte header, JSON first and the optional binary chunk second
+	size_t offset = 12;
+	JsonValue document{};
+	std::byte const* bin = nullptr;
+	size_t binSize = 0;
+	while (offset + 8 <= size)
+	{
+		size_t const chunkSize = ReadU32(data + offset);
+		uint32_t const chunkType = ReadU32(data + offset + 4);
+		std::byte const* chunk = data + offset + 8;
+		if (offset + 8 + chunkSize > size)
+		{
+			throw std::runtime_error("Truncated glTF binary file");
+		}
+
+		if (chunkType == GlbChunkJson)
+		{
+			auto const* text = reinterpret_cast<char const*>(chunk);
+			document = JsonParser(text, text + chunkSize).Parse();
+		}
+		else if (chunkType == GlbChunkBin && bin == nullptr)
+		{
+			bin = chunk;
+			binSize = chunkSize;
+		}
+		offset += 8 + ((chunkSize + 3) & ~size_t(3));
+	}
+
+	JsonValue const* meshes = document.Find("meshes");
+	if (meshes == nullptr || bin == nullptr)
+	{
+		throw std::runtime_error("glTF file has no meshes or no binary chunk");
+	}
+
+	CPU_Geometry geometry{};
+	bool hasNormals = true;
+	bool hasUVs = true;
+	for (JsonValue const& mesh : meshes->elements)
+	{
+		JsonValue const* primitives = mesh.Find("primitives");
+		if (primitives == nullptr)
+		{
+			continue;
+		}
+
+		for (JsonValue const& primitive : primitives->elements)
+		{
+			JsonValue const* attributes = primitive.Find("attributes");
+			if (primitive.Size("mode").value_or(ModeTriangles) != ModeTriangles || attributes == nullptr)
+			{
+				continue;
+			}
+
+			std::optional<size_t> const positionAccessor = attributes->Size("POSITION");
+			if (positionAccessor.has_value() == false)
+			{
+				continue;
+			}
+
+			Index const baseVertex = static_cast<Index>(geometry.positions.size());
+			GlbAccessor const positions = ResolveAccessor(document, *positionAccessor, bin, binSize);
+			ReadFloats(positions, geometry.positions);
+
+			// attributes are all or nothing across primitives, a missing one is regenerated for the whole mesh
+			std::optional<size_t> const normalAccessor = attributes->Size("NORMAL");
+			hasNormals = hasNormals && normalAccessor.has_value();
+			if (hasNormals)
+			{
+				ReadFloats(ResolveAccessor(document, *normalAccessor, bin, binSize), geometry.normals);
+			}
+
+			std::optional<size_t> const uvAccessor = attributes->Size("TEXCOORD_0");
+			hasUVs = hasUVs && uvAccessor.has_value();
+			if (hasUVs)
+			{
+				GlbAccessor const uvs = ResolveAccessor(document, *uvAccessor, bin, binSize);
+				if (uvs.componentType == ComponentFloat)
+				{
+					ReadFloats(uvs, geometry.uvs);
+					// glTF puts the uv origin at the top left
+					for (size_t i = baseVertex; i < geometry.uvs.size(); i++)
+					{
+						geometry.uvs[i].y = 1.0f - geometry.uvs[i].y;
+					}
+				}
+				else
+				{
+					hasUVs = false;
+				}
+			}
+
+			std::optional<size_t> const indexAccessor = primitive.Size("indices");
+			if (indexAccessor.has_value() == false)
+			{
+				for (Index i = 0; i < static_cast<Index>(positions.count); i++)
+				{
+					geometry.indices.push_back(baseVertex + i);
+				}
+				continue;
+			}
+
+			GlbAccessor const indices = ResolveAccessor(document, *indexAccessor, bin, binSize);
+			geometry.indices.reserve(geometry.indices.size() + indices.count);
+			for (size_t i = 0; i < indices.count; i++)
+			{
+				std::byte const* element = indices.data + i * indices.stride;
+				Index index = 0;
+				switch (indices.componentType)
+				{
+				case ComponentUnsignedByte:
+					index = static_cast<Index>(std::to_integer<uint8_t>(*element));
+					break;
+				case ComponentUnsignedShort:
+				{
+					uint16_t value = 0;
+					std::memcpy(&value, element, sizeof(value));
+					index = value;
+					break;
+				}
+				case ComponentUnsignedInt:
+					index = ReadU32(element);
+					break;
+				default:
+					throw std::runtime_error("Unsupported glTF index format");
+				}
+
+				if (index >= positions.count)
+				{
+					throw std::runtime_error("glTF index is out of bounds");
+				}
+				geometry.indices.push_back(baseVertex + index);
+			}
+		}
+	}
+
+	if (geometry.indices.empty())
+	{
+		throw std::runtime_error("glTF file has no triangle primitives");
+	}
+
+	if (hasNormals == false)
+	{
+		geometry.normals.clear();
+	}
+	if (hasUVs == false)
+	{
+		geometry.uvs.clear();
+	}
+	CompleteAttributes(geometry, hasNormals, hasUVs);
+	return geometry;
+}
+
+//======================================================================================================================
+
+void MeshLoader::NormalizeToUnitRadius(CPU_Geometry& geometry)
+{
+	if (geometry.positions.empty())
+	{
+		return;
+	}
+
+	glm::vec3 minimum{ std::numeric_limits<float>::max() };
+	glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+	for (Position const& position : geometry.positions)
+	{
+		minimum = glm::min(minimum, position);
+		maximum = glm::max(maximum, position);
+	}
+	glm::vec3 const center = (minimum + maximum) * 0.5f;
+
+	float maxRadius = 0.0f;
+	for (Position& position : geometry.positions)
+	{
+		position -= center;
+		maxRadius = std::max(maxRadius, glm::length(position));
+	}
+
+	if (maxRadius > 0.0f)
+	{
+		for (Position& position : geometry.positions)
+		{
+			position /= maxRadius;
+		}
+	}
+}
+
+//======================================================================================================================
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Geometry.h"
+
+#include <cstddef>
+#include <string>
+
+// Loads triangle meshes (e.g. shape models of irregular moons) into the same indexed CPU_Geometry the shape
+// generators produce. Files are parsed straight from a memory mapping.
+// Missing normals are computed from the faces and missing uvs are projected from the mesh center.
+namespace MeshLoader
+{
+	// Picks the parser from the extension (.obj or .glb), throws std::runtime_error if the file can't be loaded
+	[[nodiscard]]
+	CPU_Geometry Load(std::string const& path);
+
+	// Supports v/vt/vn and polygonal f records (fan triangulated, negative indices allowed), everything else is skipped
+	[[nodiscard]]
+	CPU_Geometry ParseOBJ(char const* data, size_t size);
+
+	// Binary glTF 2.0, every triangle primitive of every mesh is merged. Node transforms are ignored
+	[[nodiscard]]
+	CPU_Geometry ParseGLB(std::byte const* data, size_t size);
+
+	// Centers the mesh on its bounding box and scales it so the farthest vertex lies on the unit sphere,
+	// which makes it a drop-in replacement for the unit sphere used by the bodies
+	void NormalizeToUnitRadius(CPU_Geometry& geometry);
+}
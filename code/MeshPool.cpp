@@ -0,0 +1,131 @@
+#include "MeshPool.hpp"
+
+#include "GLState.hpp"
+
+#include <cassert>
+#include <numeric>
+
+//======================================================================================================================
+
+MeshPool::Mesh MeshPool::Add(CPU_GeometryView const& geometry)
+{
+	assert(mGeometry == nullptr);
+
+	Mesh const mesh
+	{
+		static_cast<GLuint>(mStaging.indices.size()),
+		static_cast<GLuint>(geometry.indexCount),
+		static_cast<GLint>(mStaging.positions.size())
+	};
+
+	mStaging.positions.insert(mStaging.positions.end(), geometry.positions, geometry.positions + geometry.vertexCount);
+	mStaging.colors.insert(mStaging.colors.end(), geometry.colors, geometry.colors + geometry.vertexCount);
+	mStaging.normals.insert(mStaging.normals.end(), geometry.normals, geometry.normals + geometry.vertexCount);
+	mStaging.uvs.insert(mStaging.uvs.end(), geometry.uvs, geometry.uvs + geometry.vertexCount);
+	mStaging.indices.insert(mStaging.indices.end(), geometry.indices, geometry.indices + geometry.indexCount);
+	return mesh;
+}
+
+//======================================================================================================================
+
+MeshPool::Mesh MeshPool::Add(CPU_Geometry const& geometry)
+{
+	CPU_GeometryView view{};
+	view.vertexCount = geometry.positions.size();
+	view.positions = geometry.positions.data();
+	view.colors = geometry.colors.data();
+	view.normals = geometry.normals.data();
+	view.uvs = geometry.uvs.data();
+	view.indexCount = geometry.indices.size();
+	view.indices = geometry.indices.data();
+	return Add(view);
+}
+
+//======================================================================================================================
+
+void MeshPool::Upload(GLuint const drawIdLocation, GLuint const drawIdCount)
+{
+	mGeometry = std::make_unique<GPU_Geometry>();
+	mGeometry->Update(mStaging);
+	mStaging = CPU_Geometry{};
+
+	std::vector<GLint> drawIds(drawIdCount);
+	std::iota(drawIds.begin(), drawIds.end(), 0);
+
+	// the attribute is part of the vao state
+	mGeometry->bind();
+	glBindBuffer(GL_ARRAY_BUFFER, mDrawIds);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(drawIds.size() * sizeof(GLint)), drawIds.data(), GL_STATIC_DRAW);
+	glVertexAttribIPointer(drawIdLocation, 1, GL_INT, 0, nullptr);
+	glVertexAttribDivisor(drawIdLocation, 1);
+	glEnableVertexAttribArray(drawIdLocation);
+	GLState::BindVertexArray(0);
+}
+
+//======================================================================================================================
+
+bool IndirectCommands::IsSupported()
+{
+#if defined(GL_VERSION_4_3)
+	return GLAD_GL_VERSION_4_3 != 0;
+#else
+	return false;
+#endif
+}
+
+//======================================================================================================================
+
+void IndirectCommands::Add(MeshPool::Mesh const& mesh, GLuint const drawEntry)
+{
+	mCommands.push_back({ mesh.indexCount, 1, mesh.firstIndex, mesh.baseVertex, drawEntry });
+}
+
+//======================================================================================================================
+
+void IndirectCommands::Add(MeshPool::Mesh const& mesh, Meshlets::DrawRanges const& ranges, GLuint const drawEntry)
+{
+	for (size_t i = 0; i < ranges.counts.size(); ++i)
+	{
+		auto const offset = reinterpret_cast<uintptr_t>(ranges.offsets[i]) / sizeof(Index);
+		mCommands.push_back({
+			static_cast<GLuint>(ranges.counts[i]),
+			1,
+			mesh.firstIndex + static_cast<GLuint>(offset),
+			mesh.baseVertex,
+			drawEntry
+		});
+	}
+}
+
+//======================================================================================================================
+
+void IndirectCommands::Upload()
+{
+#if defined(GL_VERSION_4_3)
+	// orphan the previous frame's storage instead of waiting for the draws that still read it
+	GLsizeiptr const size = static_cast<GLsizeiptr>(mCommands.size() * sizeof(DrawElementsIndirectCommand));
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, mCommands.data());
+#endif
+}
+
+//======================================================================================================================
+
+void IndirectCommands::Draw(size_t const first, size_t const count) const
+{
+#if defined(GL_VERSION_4_3)
+	if (count == 0)
+	{
+		return;
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mBuffer);
+	auto const offset = reinterpret_cast<void const*>(first * sizeof(DrawElementsIndirectCommand));
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, static_cast<GLsizei>(count), 0);
+#else
+	(void)first;
+	(void)count;
+#endif
+}
+
+//======================================================================================================================
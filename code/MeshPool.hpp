@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Geometry.h"
+#include "GLHandles.h"
+#include "Meshlet.hpp"
+
+#include <glad/glad.h>
+
+#include <memory>
+#include <vector>
+
+// Several meshes packed into one vertex array, so draws of different meshes can be submitted by a single
+// glMultiDrawElementsIndirect call. Indices stay relative to their mesh and are offset by baseVertex when drawn.
+//
+// The pool also carries an instanced draw id attribute holding 0, 1, 2, ..., with a divisor of 1 it reads the
+// baseInstance of the indirect command, which is how a draw finds its DrawBlock entry without gl_DrawID
+class MeshPool
+{
+public:
+
+	struct Mesh
+	{
+		GLuint firstIndex = 0;
+		GLuint indexCount = 0;
+		GLint baseVertex = 0;
+	};
+
+	MeshPool() = default;
+
+	MeshPool(MeshPool const&) = delete;
+	MeshPool& operator=(MeshPool const&) = delete;
+
+	// Appends a mesh, all attributes and indices are required. Only valid before Upload
+	Mesh Add(CPU_GeometryView const& geometry);
+
+	Mesh Add(CPU_Geometry const& geometry);
+
+	// Moves the meshes to the GPU and releases the CPU copies
+	void Upload(GLuint drawIdLocation, GLuint drawIdCount);
+
+	void Bind() const { mGeometry->bind(); }
+
+private:
+
+	CPU_Geometry mStaging{};
+	std::unique_ptr<GPU_Geometry> mGeometry{};
+	VertexBufferHandle mDrawIds{};
+};
+
+// Matches the command layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	GLuint count = 0;
+	GLuint instanceCount = 0;
+	GLuint firstIndex = 0;
+	GLint baseVertex = 0;
+	GLuint baseInstance = 0;
+};
+
+// Indirect commands of one frame, built on the CPU and uploaded once before they are drawn in ranges
+class IndirectCommands
+{
+public:
+
+	// glMultiDrawElementsIndirect is core since GL 4.3 and needs the modern loader
+	[[nodiscard]]
+	static bool IsSupported();
+
+	void Clear() { mCommands.clear(); }
+
+	[[nodiscard]]
+	size_t Size() const { return mCommands.size(); }
+
+	// Adds a draw of the whole mesh, drawEntry ends up in baseInstance
+	void Add(MeshPool::Mesh const& mesh, GLuint drawEntry);
+
+	// Adds one command per index range, offsets are relative to the start of the mesh
+	void Add(MeshPool::Mesh const& mesh, Meshlets::DrawRanges const& ranges, GLuint drawEntry);
+
+	void Upload();
+
+	// Draws commands [first, first + count) of the last upload with the mesh pool bound
+	void Draw(size_t first, size_t count) const;
+
+private:
+
+	std::vector<DrawElementsIndirectCommand> mCommands{};
+	VertexBufferHandle mBuffer{};
+};
@@ -0,0 +1,283 @@
+#include "Meshlet.hpp"
+
+#include <algorithm>
+#include <limits>
+
+//======================================================================================================================
+
+static void ComputeBounds(Meshlet& meshlet, Position const* positions, Index const* indices)
+{
+	glm::vec3 minimum{ std::numeric_limits<float>::max() };
+	glm::vec3 maximum{ std::numeric_limits<float>::lowest() };
+	for (uint32_t i = 0; i < meshlet.indexCount; i++)
+	{
+		minimum = glm::min(minimum, positions[indices[i]]);
+		maximum = glm::max(maximum, positions[indices[i]]);
+	}
+	meshlet.center = (minimum + maximum) * 0.5f;
+
+	float radius = 0.0f;
+	glm::vec3 normalSum{ 0.0f };
+	for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+	{
+		glm::vec3 const& a = positions[indices[i]];
+		glm::vec3 const& b = positions[indices[i + 1]];
+		glm::vec3 const& c = positions[indices[i + 2]];
+		radius = std::max({ radius, glm::length(a - meshlet.center), glm::length(b - meshlet.center), glm::length(c - meshlet.center) });
+
+		glm::vec3 const normal = glm::cross(b - a, c - a);
+		float const length = glm::length(normal);
+		if (length > 0.0f)
+		{
+			normalSum += normal / length;
+		}
+	}
+	meshlet.radius = radius;
+
+	float const axisLength = glm::length(normalSum);
+	if (axisLength <= 0.0f)
+	{
+		return; // degenerate cluster, keep the cone disabled
+	}
+	meshlet.coneAxis = normalSum / axisLength;
+
+	float minDot = 1.0f;
+	for (uint32_t i = 0; i < meshlet.indexCount; i += 3)
+	{
+		glm::vec3 const& a = positions[indices[i]];
+		glm::vec3 const normal = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+		float const length = glm::length(normal);
+		if (length > 0.0f)
+		{
+			minDot = std::min(minDot, glm::dot(meshlet.coneAxis, normal / length));
+		}
+	}
+	meshlet.coneCos = minDot;
+	meshlet.coneSin = std::sqrt(std::max(0.0f, 1.0f - minDot * minDot));
+}
+
+//======================================================================================================================
+
+std::vector<Meshlet> Meshlets::Build(
+	Position const* positions,
+	size_t const vertexCount,
+	Index const* indices,
+	size_t const indexCount,
+	std::vector<Index>& reorderedIndices
+)
+{
+	size_t const triangleCount = indexCount / 3;
+	constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+	// vertex -> triangles adjacency in compressed rows
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacencyOffsets[indices[i] + 1]++;
+	}
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> vertexMeshlet(vertexCount, None); // last meshlet that used the vertex
+	std::vector<uint32_t> candidateMeshlet(triangleCount, None); // last meshlet that queued the triangle
+	std::vector<uint32_t> candidates{};
+
+	std::vector<Meshlet> meshlets{};
+	reorderedIndices.clear();
+	reorderedIndices.reserve(triangleCount * 3);
+
+	size_t seed = 0;
+	while (true)
+	{
+		while (seed < triangleCount && emitted[seed])
+		{
+			seed++;
+		}
+		if (seed == triangleCount)
+		{
+			break;
+		}
+
+		uint32_t const meshletIndex = static_cast<uint32_t>(meshlets.size());
+		Meshlet meshlet{};
+		meshlet.indexOffset = static_cast<uint32_t>(reorderedIndices.size());
+		size_t meshletVertices = 0;
+
+		candidates.clear();
+		candidates.push_back(static_cast<uint32_t>(seed));
+		candidateMeshlet[seed] = meshletIndex;
+
+		while (candidates.empty() == false)
+		{
+			// prefer the triangle that adds the fewest new vertices
+			size_t best = candidates.size();
+			int bestShared = -1;
+			for (size_t c = 0; c < candidates.size();)
+			{
+				uint32_t const triangle = candidates[c];
+				if (emitted[triangle])
+				{
+					candidates[c] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+
+				int shared = 0;
+				for (size_t k = 0; k < 3; k++)
+				{
+					shared += vertexMeshlet[indices[triangle * 3 + k]] == meshletIndex ? 1 : 0;
+				}
+				if (shared > bestShared)
+				{
+					bestShared = shared;
+					best = c;
+				}
+				c++;
+			}
+			if (best == candidates.size())
+			{
+				break;
+			}
+
+			size_t const newVertices = static_cast<size_t>(3 - bestShared);
+			if (meshletVertices + newVertices > MaxVertices || meshlet.indexCount / 3 + 1 > MaxTriangles)
+			{
+				break;
+			}
+
+			uint32_t const triangle = candidates[best];
+			candidates[best] = candidates.back();
+			candidates.pop_back();
+			emitted[triangle] = true;
+			meshlet.indexCount += 3;
+
+			for (size_t k = 0; k < 3; k++)
+			{
+				Index const vertex = indices[triangle * 3 + k];
+				reorderedIndices.push_back(vertex);
+				if (vertexMeshlet[vertex] == meshletIndex)
+				{
+					continue;
+				}
+
+				vertexMeshlet[vertex] = meshletIndex;
+				meshletVertices++;
+				for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+				{
+					uint32_t const neighbour = adjacency[a];
+					if (emitted[neighbour] == false && candidateMeshlet[neighbour] != meshletIndex)
+					{
+						candidateMeshlet[neighbour] = meshletIndex;
+						candidates.push_back(neighbour);
+					}
+				}
+			}
+		}
+
+		ComputeBounds(meshlet, positions, reorderedIndices.data() + meshlet.indexOffset);
+		meshlets.push_back(meshlet);
+	}
+
+	return meshlets;
+}
+
+//======================================================================================================================
+
+Meshlets::Frustum Meshlets::Frustum::FromMatrix(glm::mat4 const& viewProjection)
+{
+	// Gribb/Hartmann plane extraction, glm matrices are column major
+	glm::mat4 const m = glm::transpose(viewProjection);
+	Frustum frustum{};
+	frustum.planes[0] = m[3] + m[0]; // left
+	frustum.planes[1] = m[3] - m[0]; // right
+	frustum.planes[2] = m[3] + m[1]; // bottom
+	frustum.planes[3] = m[3] - m[1]; // top
+	frustum.planes[4] = m[3] + m[2]; // near
+	frustum.planes[5] = m[3] - m[2]; // far
+	for (glm::vec4& plane : frustum.planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return frustum;
+}
+
+//======================================================================================================================
+
+bool Meshlets::Frustum::Intersects(glm::vec3 const& center, float const radius) const
+{
+	for (glm::vec4 const& plane : planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//======================================================================================================================
+
+void Meshlets::Cull(
+	std::vector<Meshlet> const& meshlets,
+	glm::mat4 const& model,
+	Frustum const& frustum,
+	glm::vec3 const& cameraPosition,
+	DrawRanges& ranges
+)
+{
+	float const scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+	glm::mat3 const rotation = glm::mat3(model) / (scale > 0.0f ? scale : 1.0f);
+
+	uint32_t rangeEnd = std::numeric_limits<uint32_t>::max();
+	for (Meshlet const& meshlet : meshlets)
+	{
+		glm::vec3 const center = glm::vec3(model * glm::vec4(meshlet.center, 1.0f));
+		float const radius = meshlet.radius * scale;
+
+		if (frustum.Intersects(center, radius) == false)
+		{
+			continue;
+		}
+
+		// every triangle faces away if even the normal closest to the view direction does: with theta the angle
+		// between the axis and the direction to the cluster, that is |d| * cos(theta + coneAngle) >= radius
+		if (meshlet.coneCos > 0.0f)
+		{
+			glm::vec3 const toCluster = center - cameraPosition;
+			float const distance = glm::length(toCluster);
+			if (distance > radius)
+			{
+				float const cosTheta = glm::dot(toCluster, rotation * meshlet.coneAxis) / distance;
+				float const sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+				if (distance * (cosTheta * meshlet.coneCos - sinTheta * meshlet.coneSin) >= radius)
+				{
+					continue;
+				}
+			}
+		}
+
+		if (meshlet.indexOffset == rangeEnd)
+		{
+			ranges.counts.back() += static_cast<GLsizei>(meshlet.indexCount);
+		}
+		else
+		{
+			ranges.counts.push_back(static_cast<GLsizei>(meshlet.indexCount));
+			ranges.offsets.push_back(reinterpret_cast<void const*>(static_cast<uintptr_t>(meshlet.indexOffset) * sizeof(Index)));
+		}
+		rangeEnd = meshlet.indexOffset + meshlet.indexCount;
+	}
+}
+
+//======================================================================================================================
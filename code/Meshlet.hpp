@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Geometry.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// A cluster of nearby triangles with bounds, small enough that whole clusters can be skipped when they are
+// off-screen or facing away from the camera
+struct Meshlet
+{
+	uint32_t indexOffset = 0; // first index in the reordered index buffer
+	uint32_t indexCount = 0;
+
+	glm::vec3 center{}; // bounding sphere
+	float radius = 0.0f;
+
+	glm::vec3 coneAxis{}; // average triangle normal, every normal is within the cone around it
+	float coneCos = -1.0f; // cosine of the cone half angle, <= 0 means the cluster can't be back-face culled
+	float coneSin = 0.0f;
+};
+
+namespace Meshlets
+{
+	inline static constexpr size_t MaxVertices = 64;
+	inline static constexpr size_t MaxTriangles = 124;
+
+	// Groups triangles into meshlets by growing each one through shared vertices.
+	// The triangles are written to reorderedIndices so every meshlet covers a contiguous index range
+	[[nodiscard]]
+	std::vector<Meshlet> Build(
+		Position const* positions,
+		size_t vertexCount,
+		Index const* indices,
+		size_t indexCount,
+		std::vector<Index>& reorderedIndices
+	);
+
+	struct Frustum
+	{
+		glm::vec4 planes[6]{}; // normals point inside
+
+		[[nodiscard]]
+		static Frustum FromMatrix(glm::mat4 const& viewProjection);
+
+		// false only if the sphere is completely outside one of the planes
+		[[nodiscard]]
+		bool Intersects(glm::vec3 const& center, float radius) const;
+	};
+
+	// Index ranges ready for glMultiDrawElements
+	struct DrawRanges
+	{
+		std::vector<GLsizei> counts{};
+		std::vector<void const*> offsets{};
+
+		void Clear()
+		{
+			counts.clear();
+			offsets.clear();
+		}
+	};
+
+	// Appends the clusters of a mesh drawn with model that are inside the frustum and not facing away from the
+	// camera. Consecutive ranges are merged. model is expected to have a uniform scale
+	void Cull(
+		std::vector<Meshlet> const& meshlets,
+		glm::mat4 const& model,
+		Frustum const& frustum,
+		glm::vec3 const& cameraPosition,
+		DrawRanges& ranges
+	);
+}
@@ -0,0 +1,290 @@
+#include "MipChain.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_CHAIN_SSE 1
+#include <emmintrin.h>
+#endif
+
+//======================================================================================================================
+
+namespace
+{
+	// Finer than 8 bits so the dark end of the curve, where sRGB steps are smallest, still rounds correctly
+	constexpr int EncodeTableSize = 4096;
+
+	struct Tables
+	{
+		std::array<float, 256> toLinear{};
+		std::array<unsigned char, EncodeTableSize> toSrgb{};
+	};
+
+	Tables const& GetTables()
+	{
+		static Tables const tables = []()->Tables
+		{
+			Tables result{};
+			for (int i = 0; i < 256; ++i)
+			{
+				float const c = static_cast<float>(i) / 255.0f;
+				result.toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i < EncodeTableSize; ++i)
+			{
+				float const l = static_cast<float>(i) / static_cast<float>(EncodeTableSize - 1);
+				float const c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				result.toSrgb[i] = static_cast<unsigned char>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+			}
+			return result;
+		}();
+		return tables;
+	}
+
+	//==================================================================================================================
+
+	// Expands a row to 4 floats per pixel, color linearized, alpha scaled to [0, 1], missing channels 0
+	void ToLinearRow(unsigned char const* source, int width, int channels, float* destination)
+	{
+		auto const& toLinear = GetTables().toLinear;
+		for (int x = 0; x < width; ++x)
+		{
+			unsigned char const* pixel = source + static_cast<size_t>(x) * static_cast<size_t>(channels);
+			float* out = destination + static_cast<size_t>(x) * 4;
+			for (int c = 0; c < 4; ++c)
+			{
+				out[c] = c >= channels ? 0.0f : c == 3 ? static_cast<float>(pixel[c]) / 255.0f : toLinear[pixel[c]];
+			}
+		}
+	}
+
+	//==================================================================================================================
+
+	// Averages 2x2 blocks of two expanded rows into one expanded row
+	void AverageRows(float const* row0, float const* row1, int sourceWidth, int width, float* destination)
+	{
+#if defined(MIP_CHAIN_SSE)
+		__m128 const quarter = _mm_set1_ps(0.25f);
+		for (int x = 0; x < width; ++x)
+		{
+			size_t const left = static_cast<size_t>(2 * x) * 4;
+			size_t const right = static_cast<size_t>(std::min(2 * x + 1, sourceWidth - 1)) * 4;
+			__m128 sum = _mm_add_ps(_mm_loadu_ps(row0 + left), _mm_loadu_ps(row0 + right));
+			sum = _mm_add_ps(sum, _mm_add_ps(_mm_loadu_ps(row1 + left), _mm_loadu_ps(row1 + right)));
+			_mm_storeu_ps(destination + static_cast<size_t>(x) * 4, _mm_mul_ps(sum, quarter));
+		}
+#else
+		for (int x = 0; x < width; ++x)
+		{
+			size_t const left = static_cast<size_t>(2 * x) * 4;
+			size_t const right = static_cast<size_t>(std::min(2 * x + 1, sourceWidth - 1)) * 4;
+			for (size_t c = 0; c < 4; ++c)
+			{
+				destination[static_cast<size_t>(x) * 4 + c] = 0.25f * (row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c]);
+			}
+		}
+#endif
+	}
+
+	//==================================================================================================================
+
+	// Packs an expanded row back to channels bytes per pixel
+	void ToSrgbRow(float const* source, int width, int channels, unsigned char* destination)
+	{
+		auto const& toSrgb = GetTables().toSrgb;
+		for (int x = 0; x < width; ++x)
+		{
+			float const* pixel = source + static_cast<size_t>(x) * 4;
+			unsigned char* out = destination + static_cast<size_t>(x) * static_cast<size_t>(channels);
+#if defined(MIP_CHAIN_SSE)
+			// color to table indices and alpha to bytes in one conversion
+			__m128 const scale = _mm_setr_ps(EncodeTableSize - 1, EncodeTableSize - 1, EncodeTableSize - 1, 255.0f);
+			__m128 const scaled = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pixel), scale), _mm_set1_ps(0.5f));
+			alignas(16) int indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(scaled));
+#else
+			int const indices[4] =
+			{
+				static_cast<int>(pixel[0] * (EncodeTableSize - 1) + 0.5f),
+				static_cast<int>(pixel[1] * (EncodeTableSize - 1) + 0.5f),
+				static_cast<int>(pixel[2] * (EncodeTableSize - 1) + 0.5f),
+				static_cast<int>(pixel[3] * 255.0f + 0.5f)
+			};
+#endif
+			for (int c = 0; c < channels; ++c)
+			{
+				int const index = std::clamp(indices[c], 0, c == 3 ? 255 : EncodeTableSize - 1);
+				out[c] = c == 3 ? static_cast<unsigned char>(index) : toSrgb[index];
+			}
+		}
+	}
+
+	//==================================================================================================================
+
+	void Downsample(MipChain& chain, size_t const level, ThreadPool& pool)
+	{
+		MipChain::Level const& source = chain.levels[level - 1];
+		MipChain::Level const& destination = chain.levels[level];
+		unsigned char const* sourcePixels = chain.Data(level - 1);
+		unsigned char* destinationPixels = chain.pixels.data() + destination.offset;
+		size_t const sourceRowSize = chain.RowSize(level - 1);
+		size_t const destinationRowSize = chain.RowSize(level);
+
+		auto const filterRows = [&](int const firstRow, int const endRow)->void
+		{
+			std::vector<float> row0(static_cast<size_t>(source.width) * 4);
+			std::vector<float> row1(row0.size());
+			std::vector<float> averaged(static_cast<size_t>(destination.width) * 4);
+			for (int y = firstRow; y < endRow; ++y)
+			{
+				int const y0 = 2 * y;
+				int const y1 = std::min(2 * y + 1, source.height - 1);
+				ToLinearRow(sourcePixels + sourceRowSize * static_cast<size_t>(y0), source.width, chain.channels, row0.data());
+				ToLinearRow(sourcePixels + sourceRowSize * static_cast<size_t>(y1), source.width, chain.channels, row1.data());
+				AverageRows(row0.data(), row1.data(), source.width, destination.width, averaged.data());
+				ToSrgbRow(averaged.data(), destination.width, chain.channels, destinationPixels + destinationRowSize * static_cast<size_t>(y));
+			}
+		};
+
+		// small levels are not worth the scheduling
+		size_t const pixelCount = static_cast<size_t>(destination.width) * static_cast<size_t>(destination.height);
+		if (pixelCount < 256 * 256)
+		{
+			filterRows(0, destination.height);
+			return;
+		}
+		pool.ParallelFor(0, destination.height, 64, filterRows);
+	}
+}
+
+//======================================================================================================================
+
+size_t MipChain::ByteSize() const
+{
+	if (levels.empty())
+	{
+		return 0;
+	}
+	Level const& last = levels.back();
+	return last.offset + static_cast<size_t>(last.width) * static_cast<size_t>(last.height) * static_cast<size_t>(channels);
+}
+
+//======================================================================================================================
+
+int Mips::LevelCount(int width, int height)
+{
+	int count = 1;
+	while (width > 1 || height > 1)
+	{
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		++count;
+	}
+	return count;
+}
+
+//======================================================================================================================
+
+size_t Mips::ChainSize(int width, int height, int const channels)
+{
+	size_t size = 0;
+	int const levelCount = LevelCount(width, height);
+	for (int level = 0; level < levelCount; ++level)
+	{
+		size += static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(channels);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	return size;
+}
+
+//======================================================================================================================
+
+std::vector<MipChain::Level> Mips::Layout(int width, int height, int const channels)
+{
+	std::vector<MipChain::Level> levels{};
+	size_t offset = 0;
+	int const levelCount = LevelCount(width, height);
+	for (int level = 0; level < levelCount; ++level)
+	{
+		levels.push_back({ width, height, offset });
+		offset += static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(channels);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	return levels;
+}
+
+//======================================================================================================================
+
+std::shared_ptr<MipChain> Mips::Build(unsigned char const* pixels, int const width, int const height, int const channels, ThreadPool& pool)
+{
+	auto chain = std::make_shared<MipChain>();
+	chain->channels = channels;
+	chain->levels = Layout(width, height, channels);
+
+	chain->pixels.resize(ChainSize(width, height, channels));
+	std::copy_n(pixels, chain->RowSize(0) * static_cast<size_t>(height), chain->pixels.begin());
+	for (size_t level = 1; level < chain->levels.size(); ++level)
+	{
+		Downsample(*chain, level, pool);
+	}
+	return chain;
+}
+
+//======================================================================================================================
+
+std::string MipCache::Key(std::string const& path, int const channels)
+{
+	return path + '#' + std::to_string(channels);
+}
+
+//======================================================================================================================
+
+std::shared_ptr<MipChain const> MipCache::Find(std::string const& path, int const channels)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto const found = mEntries.find(Key(path, channels));
+	if (found == mEntries.end())
+	{
+		return nullptr;
+	}
+	mRecent.splice(mRecent.begin(), mRecent, found->second.recent);
+	return found->second.chain;
+}
+
+//======================================================================================================================
+
+void MipCache::Insert(std::string const& path, int const channels, std::shared_ptr<MipChain const> chain)
+{
+	size_t const size = chain->ByteSize();
+	if (size > mBudget)
+	{
+		return; // would evict everything and still not fit
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::string key = Key(path, channels);
+	if (mEntries.count(key) != 0)
+	{
+		return; // built concurrently by another request
+	}
+
+	while (mSize + size > mBudget && mRecent.empty() == false)
+	{
+		auto const evicted = mEntries.find(mRecent.back());
+		mSize -= evicted->second.chain->ByteSize();
+		mEntries.erase(evicted);
+		mRecent.pop_back();
+	}
+
+	mRecent.push_front(key);
+	mEntries.emplace(std::move(key), Entry{ std::move(chain), mRecent.begin() });
+	mSize += size;
+}
+
+//======================================================================================================================
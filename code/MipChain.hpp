@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MappedFile;
+class ThreadPool;
+
+// An 8-bit image with all of its mip levels, tightly packed one level after the other. The pixels are either owned
+// or mapped from a file of the MipDiskCache
+struct MipChain
+{
+	struct Level
+	{
+		int width = 0;
+		int height = 0;
+		size_t offset = 0; // in pixels
+	};
+
+	int channels = 0;
+	std::vector<Level> levels{};
+	std::vector<unsigned char> pixels{};
+	std::shared_ptr<MappedFile const> file{}; // keeps mapped pixels alive
+	unsigned char const* mapped = nullptr; // first pixel in the file, used instead of pixels when set
+
+	[[nodiscard]]
+	unsigned char const* Data(size_t const level) const { return (mapped != nullptr ? mapped : pixels.data()) + levels[level].offset; }
+
+	// Bytes of all levels
+	[[nodiscard]]
+	size_t ByteSize() const;
+
+	[[nodiscard]]
+	size_t RowSize(size_t const level) const { return static_cast<size_t>(levels[level].width) * static_cast<size_t>(channels); }
+};
+
+namespace Mips
+{
+	// Number of levels down to 1x1, sizes halve rounding down like GL does
+	[[nodiscard]]
+	int LevelCount(int width, int height);
+
+	// Bytes of all levels of an 8-bit image
+	[[nodiscard]]
+	size_t ChainSize(int width, int height, int channels);
+
+	// Sizes and offsets of every level, without pixels
+	[[nodiscard]]
+	std::vector<MipChain::Level> Layout(int width, int height, int channels);
+
+	// Builds the full chain with a gamma-correct 2x2 box filter: the color channels are averaged in linear space and
+	// encoded back to sRGB, a fourth channel is treated as linear alpha. Rows of large levels are spread over the
+	// pool, each row is filtered with SSE where available
+	[[nodiscard]]
+	std::shared_ptr<MipChain> Build(unsigned char const* pixels, int width, int height, int channels, ThreadPool& pool);
+}
+
+// Built mip chains by image path and channel count, the least recently used ones are evicted over the budget.
+// Safe to use from several threads
+class MipCache
+{
+public:
+
+	static constexpr size_t DefaultBudget = 128 * 1024 * 1024;
+
+	explicit MipCache(size_t budget = DefaultBudget) : mBudget(budget) {}
+
+	[[nodiscard]]
+	std::shared_ptr<MipChain const> Find(std::string const& path, int channels);
+
+	void Insert(std::string const& path, int channels, std::shared_ptr<MipChain const> chain);
+
+private:
+
+	struct Entry
+	{
+		std::shared_ptr<MipChain const> chain{};
+		std::list<std::string>::iterator recent{};
+	};
+
+	static std::string Key(std::string const& path, int channels);
+
+	size_t mBudget;
+	size_t mSize = 0;
+	std::mutex mMutex{};
+	std::unordered_map<std::string, Entry> mEntries{};
+	std::list<std::string> mRecent{}; // most recently used first
+};
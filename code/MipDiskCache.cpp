@@ -0,0 +1,122 @@
+#include "MipDiskCache.hpp"
+
+#include "DiskCache.hpp"
+#include "Log.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <vector>
+
+namespace MipDiskCache
+{
+
+	//==================================================================================================================
+
+	static constexpr uint32_t Magic = 0x5350494D; // "MIPS"
+	static constexpr size_t PixelAlignment = 64;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t keyHash;
+		uint32_t width;
+		uint32_t height;
+		uint32_t channels;
+		uint32_t levelCount;
+		uint64_t pixelsOffset;
+		uint64_t fileSize;
+	};
+
+	//==================================================================================================================
+
+	static uint64_t HashKey(uint64_t const sourceHash, int const channels)
+	{
+		uint64_t hash = DiskCache::Hash(&Version, sizeof(Version));
+		hash = DiskCache::Hash(&sourceHash, sizeof(sourceHash), hash);
+		return DiskCache::Hash(&channels, sizeof(channels), hash);
+	}
+
+	//==================================================================================================================
+
+	static std::filesystem::path PathFor(std::string const& path, uint64_t const keyHash)
+	{
+		std::string const stem = std::filesystem::path(path).stem().string();
+		return DiskCache::Directory("textures") / fmt::format("{}_{:016x}.mips", stem, keyHash);
+	}
+
+	//==================================================================================================================
+
+	static Header MakeHeader(uint64_t const keyHash, int const width, int const height, int const channels)
+	{
+		Header header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.keyHash = keyHash;
+		header.width = static_cast<uint32_t>(width);
+		header.height = static_cast<uint32_t>(height);
+		header.channels = static_cast<uint32_t>(channels);
+		header.levelCount = static_cast<uint32_t>(Mips::LevelCount(width, height));
+		header.pixelsOffset = (sizeof(Header) + PixelAlignment - 1) & ~(PixelAlignment - 1);
+		header.fileSize = header.pixelsOffset + Mips::ChainSize(width, height, channels);
+		return header;
+	}
+
+	//==================================================================================================================
+
+	uint64_t SourceHash(std::string const& path)
+	{
+		return DiskCache::HashFile(path);
+	}
+
+	//==================================================================================================================
+
+	std::shared_ptr<MipChain const> Load(std::string const& path, uint64_t const sourceHash, int const channels)
+	{
+		uint64_t const keyHash = HashKey(sourceHash, channels);
+		auto file = std::make_shared<MappedFile>(PathFor(path, keyHash).string());
+		if (file->IsValid() == false || file->Size() < sizeof(Header))
+		{
+			return nullptr;
+		}
+
+		Header header{};
+		std::memcpy(&header, file->Data(), sizeof(Header));
+		if (header.magic != Magic || header.version != Version || header.keyHash != keyHash || header.width == 0 || header.height == 0)
+		{
+			return nullptr;
+		}
+
+		// everything else follows from the size, so a matching header guarantees the levels are where we expect
+		Header const expected = MakeHeader(keyHash, static_cast<int>(header.width), static_cast<int>(header.height), channels);
+		if (std::memcmp(&header, &expected, sizeof(Header)) != 0 || file->Size() < header.fileSize)
+		{
+			return nullptr;
+		}
+
+		auto chain = std::make_shared<MipChain>();
+		chain->channels = channels;
+		chain->levels = Mips::Layout(static_cast<int>(header.width), static_cast<int>(header.height), channels);
+		chain->mapped = reinterpret_cast<unsigned char const*>(file->Data() + header.pixelsOffset);
+		chain->file = std::move(file);
+		return chain;
+	}
+
+	//==================================================================================================================
+
+	void Store(std::string const& path, uint64_t const sourceHash, MipChain const& chain)
+	{
+		uint64_t const keyHash = HashKey(sourceHash, chain.channels);
+		Header const header = MakeHeader(keyHash, chain.levels[0].width, chain.levels[0].height, chain.channels);
+		// straight from the chain, a copy of the 8k star map alone would take over 100 MiB
+		static constexpr std::byte Padding[PixelAlignment]{};
+		DiskCache::WriteFile(PathFor(path, keyHash), {
+			{ &header, sizeof(Header) },
+			{ Padding, header.pixelsOffset - sizeof(Header) },
+			{ chain.Data(0), chain.ByteSize() }
+		});
+	}
+
+	//==================================================================================================================
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "MipChain.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Versioned disk cache of decoded images with all of their mip levels, ready to upload.
+// Entries are keyed by a hash of the image file's bytes and the channel count, so an edited image misses and is
+// decoded again. Later runs memory-map the entry and upload the levels straight from the mapping, without decoding the
+// image or filtering its levels.
+namespace MipDiskCache
+{
+	// Bump whenever the file layout or the output of Mips::Build changes
+	inline static constexpr uint32_t Version = 1;
+
+	// Hash of the bytes of the image file, 0 when it cannot be read
+	[[nodiscard]]
+	uint64_t SourceHash(std::string const& path);
+
+	// The cached chain of the image at path, nullptr on a miss
+	[[nodiscard]]
+	std::shared_ptr<MipChain const> Load(std::string const& path, uint64_t sourceHash, int channels);
+
+	// Writes the chain built from the image at path for the next run
+	void Store(std::string const& path, uint64_t sourceHash, MipChain const& chain);
+}
@@ -0,0 +1,344 @@
+#include "PageCache.hpp"
+
+#include "GLState.hpp"
+#include "Log.h"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+//======================================================================================================================
+
+namespace
+{
+	constexpr uint32_t MaxPagesPerSide = 1u << 12;
+	constexpr int MaxLevels = 16;
+
+	uint32_t TextureOf(uint32_t const page) { return page >> 28; }
+	int LevelOf(uint32_t const page) { return static_cast<int>((page >> 24) & 0xF); }
+	int YOf(uint32_t const page) { return static_cast<int>((page >> 12) & 0xFFF); }
+	int XOf(uint32_t const page) { return static_cast<int>(page & 0xFFF); }
+
+	// page table texel, read as rgba8 by the shader: slot x, slot y, level of the page in the slot
+	uint32_t TableEntry(int const slotX, int const slotY, int const level)
+	{
+		return static_cast<uint32_t>(slotX) | static_cast<uint32_t>(slotY) << 8 | static_cast<uint32_t>(level) << 16 | 0xFFu << 24;
+	}
+}
+
+//======================================================================================================================
+
+PageCache::PageCache(int const slotsPerSide)
+	: mPool(ThreadPool::Instance())
+	, mSlotsPerSide(std::clamp(slotsPerSide, 4, 255)) // slot coordinates are 8 bits in the page tables
+	, mSlots(static_cast<size_t>(mSlotsPerSide) * static_cast<size_t>(mSlotsPerSide))
+{
+	int const size = mSlotsPerSide * PageFile::PaddedSize;
+	GLState::BindTexture(0, GL_TEXTURE_2D, mCache);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLState::BindTexture(0, GL_TEXTURE_2D, 0);
+
+	Log::info("Page cache: {} slots of {}x{}, {:.1f} MiB", mSlots.size(), PageFile::PaddedSize, PageFile::PaddedSize,
+		static_cast<double>(size) * size * PageFile::Channels / (1024.0 * 1024.0));
+}
+
+//======================================================================================================================
+
+PageCache::~PageCache()
+{
+	// loads that did not start yet return right away, the running ones have to finish before this is gone
+	mStopping = true;
+	for (std::future<void>& load : mLoads)
+	{
+		load.wait();
+	}
+}
+
+//======================================================================================================================
+
+int PageCache::Add(std::unique_ptr<PageFile> file)
+{
+	if (mTextures.size() >= MaxTextures || file->LevelCount() > MaxLevels
+		|| static_cast<uint32_t>(file->PagesWide(0)) > MaxPagesPerSide || static_cast<uint32_t>(file->PagesHigh(0)) > MaxPagesPerSide)
+	{
+		Log::warning("Virtual texture of {}x{} does not fit in the page cache", file->Width(), file->Height());
+		return -1;
+	}
+
+	int const id = static_cast<int>(mTextures.size());
+	VirtualTexture& texture = mTextures.emplace_back();
+	texture.file = std::move(file);
+	PageFile const& pages = *texture.file;
+
+	// the levels of the table halve like the pages, so the shader fetches the table texel of a page at its level
+	GLState::BindTexture(0, GL_TEXTURE_2D, texture.table);
+	for (int level = 0; level < pages.LevelCount(); ++level)
+	{
+		int const width = pages.PagesWide(level);
+		int const height = pages.PagesHigh(level);
+		texture.slots.emplace_back(static_cast<size_t>(width) * static_cast<size_t>(height), -1);
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, pages.LevelCount() - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	// every page falls back to the coarsest level, it is always there
+	int const coarsest = pages.LevelCount() - 1;
+	Upload(Pack(static_cast<uint32_t>(id), static_cast<uint32_t>(coarsest), 0, 0), pages.Page(coarsest, 0, 0), true);
+	UpdateTable(texture);
+
+	Log::info("Virtual texture {}: {}x{} in {} levels, {} pages at the finest level", id, pages.Width(), pages.Height(),
+		pages.LevelCount(), pages.PagesWide(0) * pages.PagesHigh(0));
+	return id;
+}
+
+//======================================================================================================================
+
+void PageCache::Request(std::vector<uint32_t> const& feedback)
+{
+	mWanted.clear();
+	for (uint32_t const seen : feedback)
+	{
+		uint32_t const id = TextureOf(seen);
+		if (id >= mTextures.size())
+		{
+			continue; // empty texel
+		}
+		PageFile const& pages = *mTextures[id].file;
+		int level = LevelOf(seen);
+		int x = XOf(seen);
+		int y = YOf(seen);
+		if (level >= pages.LevelCount() || x >= pages.PagesWide(level) || y >= pages.PagesHigh(level))
+		{
+			continue;
+		}
+
+		// the page and its ancestors, until the page arrives they are what gets sampled
+		while (true)
+		{
+			uint32_t const page = Pack(id, static_cast<uint32_t>(level), static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+			auto const resident = mResident.find(page);
+			if (resident != mResident.end())
+			{
+				mSlots[static_cast<size_t>(resident->second)].lastSeen = mFrame;
+			}
+			else if (mLoading.count(page) == 0)
+			{
+				mWanted.push_back(page);
+			}
+			if (level + 1 == pages.LevelCount())
+			{
+				break;
+			}
+			++level;
+			x >>= 1;
+			y >>= 1;
+		}
+	}
+
+	// coarse levels first, they cover the most of the screen and refine progressively
+	std::sort(mWanted.begin(), mWanted.end());
+	mWanted.erase(std::unique(mWanted.begin(), mWanted.end()), mWanted.end());
+	std::stable_sort(mWanted.begin(), mWanted.end(), [](uint32_t const a, uint32_t const b)->bool
+	{
+		return LevelOf(a) > LevelOf(b);
+	});
+
+	for (uint32_t const page : mWanted)
+	{
+		if (mLoading.size() >= MaxLoadsInFlight)
+		{
+			break;
+		}
+		mLoading.insert(page);
+		std::byte const* const data = mTextures[TextureOf(page)].file->Page(LevelOf(page), XOf(page), YOf(page));
+		mLoads.push_back(mPool->Submit([this, page, data]()->void
+		{
+			// reading the mapped file pages it in from disk here rather than on the GL thread
+			Loaded loaded{ page, {} };
+			if (mStopping == false)
+			{
+				loaded.texels.assign(data, data + PageFile::PageBytes);
+			}
+			std::lock_guard<std::mutex> lock(mMutex);
+			mLoaded.push_back(std::move(loaded));
+		}));
+	}
+}
+
+//======================================================================================================================
+
+void PageCache::Update()
+{
+	mLoads.erase(std::remove_if(mLoads.begin(), mLoads.end(), [](std::future<void> const& load)->bool
+	{
+		return load.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}), mLoads.end());
+
+	std::vector<Loaded> uploads{};
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		while (mLoaded.empty() == false && uploads.size() < UploadsPerFrame)
+		{
+			uploads.push_back(std::move(mLoaded.front()));
+			mLoaded.pop_front();
+		}
+	}
+
+	for (Loaded const& loaded : uploads)
+	{
+		mLoading.erase(loaded.page);
+		if (loaded.texels.empty() == false)
+		{
+			Upload(loaded.page, loaded.texels.data(), false);
+		}
+	}
+
+	for (VirtualTexture& texture : mTextures)
+	{
+		if (texture.dirty)
+		{
+			UpdateTable(texture);
+		}
+	}
+	++mFrame;
+}
+
+//======================================================================================================================
+
+int PageCache::AcquireSlot()
+{
+	// a free slot, otherwise the least recently seen page that wasn't seen this frame
+	int best = -1;
+	for (size_t slot = 0; slot < mSlots.size(); ++slot)
+	{
+		Slot const& candidate = mSlots[slot];
+		if (candidate.page == NoPage)
+		{
+			return static_cast<int>(slot);
+		}
+		if (candidate.pinned == false && candidate.lastSeen < mFrame
+			&& (best < 0 || candidate.lastSeen < mSlots[static_cast<size_t>(best)].lastSeen))
+		{
+			best = static_cast<int>(slot);
+		}
+	}
+	return best;
+}
+
+//======================================================================================================================
+
+void PageCache::Upload(uint32_t const page, std::byte const* const texels, bool const pinned)
+{
+	int const slot = AcquireSlot();
+	if (slot < 0)
+	{
+		return; // everything in the cache is on screen, the feedback requests the page again
+	}
+
+	Slot& target = mSlots[static_cast<size_t>(slot)];
+	if (target.page != NoPage)
+	{
+		VirtualTexture& evicted = mTextures[TextureOf(target.page)];
+		int const level = LevelOf(target.page);
+		size_t const index = static_cast<size_t>(YOf(target.page)) * static_cast<size_t>(evicted.file->PagesWide(level)) + static_cast<size_t>(XOf(target.page));
+		evicted.slots[static_cast<size_t>(level)][index] = -1;
+		evicted.dirty = true;
+		mResident.erase(target.page);
+	}
+	target = { page, mFrame, pinned };
+	mResident[page] = slot;
+
+	VirtualTexture& texture = mTextures[TextureOf(page)];
+	int const level = LevelOf(page);
+	size_t const index = static_cast<size_t>(YOf(page)) * static_cast<size_t>(texture.file->PagesWide(level)) + static_cast<size_t>(XOf(page));
+	texture.slots[static_cast<size_t>(level)][index] = slot;
+	texture.dirty = true;
+
+	int const slotX = slot % mSlotsPerSide;
+	int const slotY = slot / mSlotsPerSide;
+	GLState::BindTexture(0, GL_TEXTURE_2D, mCache);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, slotX * PageFile::PaddedSize, slotY * PageFile::PaddedSize, PageFile::PaddedSize,
+		PageFile::PaddedSize, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+}
+
+//======================================================================================================================
+
+void PageCache::UpdateTable(VirtualTexture& texture)
+{
+	// from the coarsest level down, a page that isn't resident takes the entry of its parent
+	PageFile const& pages = *texture.file;
+	std::vector<uint32_t> entries{};
+	std::vector<uint32_t> parents{};
+	int parentsWide = 1;
+
+	GLState::BindTexture(0, GL_TEXTURE_2D, texture.table);
+	for (int level = pages.LevelCount() - 1; level >= 0; --level)
+	{
+		int const width = pages.PagesWide(level);
+		int const height = pages.PagesHigh(level);
+		std::vector<int> const& slots = texture.slots[static_cast<size_t>(level)];
+		entries.resize(slots.size());
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				size_t const index = static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x);
+				int const slot = slots[index];
+				if (slot >= 0)
+				{
+					entries[index] = TableEntry(slot % mSlotsPerSide, slot / mSlotsPerSide, level);
+				}
+				else
+				{
+					// zero alpha if not even the coarsest page found a slot
+					entries[index] = parents.empty() ? 0 : parents[static_cast<size_t>(y / 2) * static_cast<size_t>(parentsWide) + static_cast<size_t>(x / 2)];
+				}
+			}
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, entries.data());
+		entries.swap(parents);
+		parentsWide = width;
+	}
+	texture.dirty = false;
+}
+
+//======================================================================================================================
+
+void PageCache::Bind(int const texture, GLuint const cacheUnit, GLuint const tableUnit) const
+{
+	GLState::BindTexture(cacheUnit, GL_TEXTURE_2D, mCache);
+	GLState::BindTexture(tableUnit, GL_TEXTURE_2D, mTextures[static_cast<size_t>(texture)].table);
+}
+
+//======================================================================================================================
+
+glm::vec4 PageCache::Parameters(int const texture) const
+{
+	PageFile const& pages = *mTextures[static_cast<size_t>(texture)].file;
+	return { pages.Width(), pages.Height(), pages.LevelCount(), mSlotsPerSide };
+}
+
+//======================================================================================================================
+
+size_t PageCache::ByteSize() const
+{
+	size_t const cacheSide = static_cast<size_t>(mSlotsPerSide) * PageFile::PaddedSize;
+	size_t size = cacheSide * cacheSide * PageFile::Channels;
+	for (VirtualTexture const& texture : mTextures)
+	{
+		for (std::vector<int> const& level : texture.slots)
+		{
+			size += level.size() * sizeof(uint32_t);
+		}
+	}
+	return size;
+}
+
+//======================================================================================================================
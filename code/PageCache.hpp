@@ -0,0 +1,132 @@
+#pragma once
+
+#include "GLHandles.h"
+#include "PageFile.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class ThreadPool;
+
+// Virtual texturing: the pages of every virtual texture share one cache texture of PageFile::PaddedSize slots, and
+// each virtual texture has a page table texture with one texel per page and one level per page file level. A table
+// texel holds the cache slot of the page, or of its nearest resident ancestor, so a missing page samples a coarser
+// one. The coarsest level of each virtual texture is loaded when it is added and never evicted.
+//
+// Pages seen by the feedback pass are read from the memory-mapped page files on the ThreadPool and uploaded in a
+// few slots per frame, evicting the least recently seen pages. Video memory stays at the cache size whatever the
+// resolution of the page files.
+//
+// Usage per frame on the GL thread: Request() with the feedback, Update(), then Bind() for each virtual texture drawn
+class PageCache
+{
+public:
+
+	static constexpr int DefaultSlotsPerSide = 16; // 16 x 16 pages of 136 x 136 texels, 18 MiB
+	static constexpr size_t MaxTextures = 15;      // the id has 4 bits in the feedback, 15 marks empty texels
+	static constexpr size_t UploadsPerFrame = 16;
+	static constexpr size_t MaxLoadsInFlight = 64;
+
+	// Feedback texel of a page: texture(4) | level(4) | y(12) | x(12), must match feedback.frag
+	[[nodiscard]]
+	static constexpr uint32_t Pack(uint32_t const texture, uint32_t const level, uint32_t const x, uint32_t const y)
+	{
+		return texture << 28 | level << 24 | y << 12 | x;
+	}
+
+	explicit PageCache(int slotsPerSide = DefaultSlotsPerSide);
+
+	~PageCache();
+
+	PageCache(PageCache const&) = delete;
+	PageCache& operator=(PageCache const&) = delete;
+
+	// Adds a virtual texture and returns its id, -1 if there are MaxTextures already or its pages are too many
+	[[nodiscard]]
+	int Add(std::unique_ptr<PageFile> file);
+
+	// Marks the pages in the feedback as seen and loads the missing ones, coarse levels first
+	void Request(std::vector<uint32_t> const& feedback);
+
+	// Uploads loaded pages within the frame's budget and updates the page tables
+	void Update();
+
+	// Binds the cache texture and the page table of the virtual texture
+	void Bind(int texture, GLuint cacheUnit, GLuint tableUnit) const;
+
+	// xy: texels of level 0, z: level count, w: slots per side of the cache
+	[[nodiscard]]
+	glm::vec4 Parameters(int texture) const;
+
+	[[nodiscard]]
+	size_t ResidentCount() const { return mResident.size(); }
+
+	[[nodiscard]]
+	size_t SlotCount() const { return mSlots.size(); }
+
+	[[nodiscard]]
+	size_t PendingCount() const { return mLoading.size(); }
+
+	// Video memory of the cache and the page tables
+	[[nodiscard]]
+	size_t ByteSize() const;
+
+private:
+
+	static constexpr uint32_t NoPage = 0xFFFFFFFFu;
+
+	struct Slot
+	{
+		uint32_t page = NoPage;
+		uint64_t lastSeen = 0;
+		bool pinned = false;
+	};
+
+	struct VirtualTexture
+	{
+		std::unique_ptr<PageFile> file{};
+		TextureHandle table{};
+		std::vector<std::vector<int>> slots{}; // per level and page, -1 when not resident
+		bool dirty = true;
+	};
+
+	struct Loaded
+	{
+		uint32_t page = NoPage;
+		std::vector<std::byte> texels{};
+	};
+
+	[[nodiscard]]
+	int AcquireSlot();
+
+	void Upload(uint32_t page, std::byte const* texels, bool pinned);
+
+	void UpdateTable(VirtualTexture& texture);
+
+	std::shared_ptr<ThreadPool> mPool{};
+	TextureHandle mCache{};
+	int mSlotsPerSide;
+	std::vector<Slot> mSlots{};
+	std::vector<VirtualTexture> mTextures{};
+	uint64_t mFrame = 1;
+
+	std::unordered_map<uint32_t, int> mResident{}; // page to slot
+	std::unordered_set<uint32_t> mLoading{};
+	std::vector<uint32_t> mWanted{};
+
+	std::vector<std::future<void>> mLoads{};
+	std::atomic<bool> mStopping{ false };
+	std::mutex mMutex{};
+	std::deque<Loaded> mLoaded{}; // guarded by mMutex, filled by the workers
+};
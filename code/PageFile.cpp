@@ -0,0 +1,173 @@
+#include "PageFile.hpp"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+//======================================================================================================================
+
+namespace
+{
+	constexpr uint32_t Magic = 0x47505456; // "VTPG"
+	constexpr uint32_t Version = 1;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t pageSize;
+		uint32_t border;
+		uint32_t levelCount;
+		uint32_t reserved;
+	};
+
+	bool IsPowerOfTwo(int const value)
+	{
+		return value > 0 && (value & (value - 1)) == 0;
+	}
+
+	// levels until a single page covers the image
+	int PageLevelCount(int const width, int const height)
+	{
+		int levels = 1;
+		while ((width / PageFile::PageSize) >> (levels - 1) > 1 || (height / PageFile::PageSize) >> (levels - 1) > 1)
+		{
+			++levels;
+		}
+		return levels;
+	}
+}
+
+//======================================================================================================================
+
+std::unique_ptr<PageFile> PageFile::Load(std::string const& path)
+{
+	MappedFile file(path);
+	if (file.IsValid() == false)
+	{
+		return nullptr;
+	}
+
+	Header header{};
+	if (file.Size() >= sizeof(Header))
+	{
+		std::memcpy(&header, file.Data(), sizeof(Header));
+	}
+	int const width = static_cast<int>(header.width);
+	int const height = static_cast<int>(header.height);
+	if (header.magic != Magic || header.version != Version || header.pageSize != PageSize || header.border != Border
+		|| IsPowerOfTwo(width) == false || IsPowerOfTwo(height) == false || width < PageSize || height < PageSize
+		|| static_cast<int>(header.levelCount) != PageLevelCount(width, height))
+	{
+		Log::warning("Unsupported or malformed page file {}", path);
+		return nullptr;
+	}
+
+	std::unique_ptr<PageFile> pages(new PageFile(std::move(file)));
+	pages->mWidth = width;
+	pages->mHeight = height;
+	pages->mLevelCount = static_cast<int>(header.levelCount);
+	size_t pageCount = 0;
+	for (int level = 0; level < pages->mLevelCount; ++level)
+	{
+		pages->mLevelOffsets.push_back(pageCount);
+		pageCount += static_cast<size_t>(pages->PagesWide(level)) * static_cast<size_t>(pages->PagesHigh(level));
+	}
+	if (pages->mFile.Size() < sizeof(Header) + pageCount * PageBytes)
+	{
+		Log::warning("Truncated page file {}", path);
+		return nullptr;
+	}
+	return pages;
+}
+
+//======================================================================================================================
+
+std::string PageFile::PathFor(std::string const& imagePath)
+{
+	std::filesystem::path const source(imagePath);
+	std::filesystem::path candidate = source.parent_path() / "pages" / source.stem();
+	candidate += ".vtpages";
+	std::error_code error{};
+	return std::filesystem::exists(candidate, error) ? candidate.string() : std::string{};
+}
+
+//======================================================================================================================
+
+bool PageFile::Write(std::filesystem::path const& path, MipChain const& chain)
+{
+	int const width = chain.levels.front().width;
+	int const height = chain.levels.front().height;
+	if (chain.channels != Channels || IsPowerOfTwo(width) == false || IsPowerOfTwo(height) == false
+		|| width < PageSize || height < PageSize)
+	{
+		Log::error("Page files need an RGBA image with power of two sides of at least {} texels", PageSize);
+		return false;
+	}
+
+	// written next to the destination and renamed, like DiskCache::WriteFile, without holding every page in memory
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+	std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+	if (stream.is_open() == false)
+	{
+		return false;
+	}
+
+	int const levelCount = PageLevelCount(width, height);
+	Header const header{ Magic, Version, static_cast<uint32_t>(width), static_cast<uint32_t>(height), PageSize, Border, static_cast<uint32_t>(levelCount), 0 };
+	stream.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+
+	std::vector<unsigned char> page(PageBytes);
+	for (int level = 0; level < levelCount; ++level)
+	{
+		MipChain::Level const& mip = chain.levels[static_cast<size_t>(level)];
+		unsigned char const* const pixels = chain.Data(static_cast<size_t>(level));
+		int const pagesWide = std::max((width / PageSize) >> level, 1);
+		int const pagesHigh = std::max((height / PageSize) >> level, 1);
+		for (int pageY = 0; pageY < pagesHigh; ++pageY)
+		{
+			for (int pageX = 0; pageX < pagesWide; ++pageX)
+			{
+				for (int y = 0; y < PaddedSize; ++y)
+				{
+					int const sourceY = std::clamp(pageY * PageSize + y - Border, 0, mip.height - 1);
+					for (int x = 0; x < PaddedSize; ++x)
+					{
+						int const sourceX = ((pageX * PageSize + x - Border) % mip.width + mip.width) % mip.width;
+						std::memcpy(
+							page.data() + (static_cast<size_t>(y) * PaddedSize + static_cast<size_t>(x)) * Channels,
+							pixels + (static_cast<size_t>(sourceY) * static_cast<size_t>(mip.width) + static_cast<size_t>(sourceX)) * Channels,
+							Channels
+						);
+					}
+				}
+				stream.write(reinterpret_cast<char const*>(page.data()), static_cast<std::streamsize>(page.size()));
+			}
+		}
+	}
+
+	stream.close();
+	if (stream.fail())
+	{
+		return false;
+	}
+	std::error_code error{};
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+//======================================================================================================================
+
+std::byte const* PageFile::Page(int const level, int const x, int const y) const
+{
+	size_t const index = mLevelOffsets[static_cast<size_t>(level)] + static_cast<size_t>(y) * static_cast<size_t>(PagesWide(level)) + static_cast<size_t>(x);
+	return mFile.Data() + sizeof(Header) + index * PageBytes;
+}
+
+//======================================================================================================================
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Pre-tiled image for virtual texturing: every mip level cut into pages of PageSize texels with a border of
+// neighbouring texels around each, so pages filter bilinearly without seams. Levels go down until the whole image
+// fits in one page. Pages are stored level by level, row by row, as RGBA8 with the bottom row first like GL
+class PageFile
+{
+public:
+
+	static constexpr int PageSize = 128;
+	static constexpr int Border = 4;
+	static constexpr int PaddedSize = PageSize + 2 * Border;
+	static constexpr int Channels = 4;
+	static constexpr size_t PageBytes = static_cast<size_t>(PaddedSize) * PaddedSize * Channels;
+
+	// Returns null if the file is missing or malformed
+	[[nodiscard]]
+	static std::unique_ptr<PageFile> Load(std::string const& path);
+
+	// The page file made for a source image, textures/pages/<name>.vtpages. Empty if there is none
+	[[nodiscard]]
+	static std::string PathFor(std::string const& imagePath);
+
+	// Tiles an RGBA chain whose size is a power of two of at least PageSize. Longitude wraps horizontally, the rows
+	// clamp at the poles
+	static bool Write(std::filesystem::path const& path, MipChain const& chain);
+
+	[[nodiscard]]
+	int Width() const { return mWidth; }
+
+	[[nodiscard]]
+	int Height() const { return mHeight; }
+
+	[[nodiscard]]
+	int LevelCount() const { return mLevelCount; }
+
+	// Pages of a level, halving like the GL mip levels of a texture with PagesWide(0) x PagesHigh(0) texels
+	[[nodiscard]]
+	int PagesWide(int level) const { return std::max((mWidth / PageSize) >> level, 1); }
+
+	[[nodiscard]]
+	int PagesHigh(int level) const { return std::max((mHeight / PageSize) >> level, 1); }
+
+	// PageBytes texels of the page, reading them may page the file in from disk
+	[[nodiscard]]
+	std::byte const* Page(int level, int x, int y) const;
+
+private:
+
+	explicit PageFile(MappedFile file) : mFile(std::move(file)) {}
+
+	MappedFile mFile;
+	int mWidth = 0;
+	int mHeight = 0;
+	int mLevelCount = 0;
+	std::vector<size_t> mLevelOffsets{}; // in pages
+};
@@ -0,0 +1,65 @@
+#include "ParallelCompile.hpp"
+
+#include "Log.h"
+
+#include <GLFW/glfw3.h>
+
+namespace ParallelCompile
+{
+
+	//==================================================================================================================
+
+	// enums of the extensions, neither loader defines them
+	static constexpr GLenum CompletionStatus = 0x91B1; // GL_COMPLETION_STATUS_KHR
+	static constexpr GLuint DriverThreadCount = 0xFFFFFFFF; // lets the driver choose how many threads compile
+
+	using MaxShaderCompilerThreadsFunction = void (APIENTRYP)(GLuint count);
+
+	//==================================================================================================================
+
+	bool IsSupported()
+	{
+		static bool const supported = []()->bool
+		{
+			char const* function = nullptr;
+			if (glfwExtensionSupported("GL_KHR_parallel_shader_compile") == GLFW_TRUE)
+			{
+				function = "glMaxShaderCompilerThreadsKHR";
+			}
+			else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile") == GLFW_TRUE)
+			{
+				function = "glMaxShaderCompilerThreadsARB";
+			}
+			else
+			{
+				Log::info("SHADER no parallel shader compile, new programs are finished one per frame");
+				return false;
+			}
+
+			// some drivers only compile in the background once a thread count was set
+			auto const maxThreads = reinterpret_cast<MaxShaderCompilerThreadsFunction>(glfwGetProcAddress(function));
+			if (maxThreads != nullptr)
+			{
+				maxThreads(DriverThreadCount);
+			}
+			return true;
+		}();
+		return supported;
+	}
+
+	//==================================================================================================================
+
+	bool IsComplete(GLuint const program)
+	{
+		if (IsSupported() == false)
+		{
+			return false;
+		}
+		GLint complete = GL_FALSE;
+		glGetProgramiv(program, CompletionStatus, &complete);
+		return complete == GL_TRUE;
+	}
+
+	//==================================================================================================================
+
+}
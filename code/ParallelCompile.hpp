@@ -0,0 +1,18 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// KHR_parallel_shader_compile, or ARB_parallel_shader_compile with the same enums. With it the driver compiles and
+// links on its own threads and a program reports when it is done, so checking on it never blocks. Without it the
+// driver may still build in the background, but the first query of a status waits for the build.
+namespace ParallelCompile
+{
+	// Whether the context has either extension. The first call lets the driver pick its number of compiler threads,
+	// so make it before submitting shaders, needs a current context
+	[[nodiscard]]
+	bool IsSupported();
+
+	// Whether the driver finished linking program, never blocks. Always false without the extension
+	[[nodiscard]]
+	bool IsComplete(GLuint program);
+}
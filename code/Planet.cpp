@@ -1,11 +1,12 @@
 #include "Planet.h"
+#include "TextureCache.hpp"
 #include <iostream>
 
 Planet::Planet(std::string const& texture, float orbitRadius, float scale, float orbitSpeed, float rotationSpeed, float tilt, float inclination, glm::vec3 centerOfOrbit)
 	: mOrbitRadius(orbitRadius), mOrbitSpeed(orbitSpeed), mRotationSpeed(rotationSpeed), mTilt(tilt), mInclination(inclination), mCenterOfOrbit(centerOfOrbit)
 {
 	mPath = AssetPath::Instance();
-	mTexture = std::make_unique<Texture>(mPath->Get(texture), GL_NEAREST);
+	mTexturePath = mPath->Get(texture);
 	mScale = glm::scale(glm::mat4(1.0f), glm::vec3(scale, scale, scale)); // scale matrix
 	mCenterOfOrbit = centerOfOrbit;
 
@@ -16,6 +17,15 @@ Planet::Planet(std::string const& texture, float orbitRadius, float scale, float
 	update(0.0f); // update the model matrix
 }
 
+Texture* Planet::getTexture()
+{
+	if (mTexture == nullptr)
+	{
+		mTexture = TextureCache::Instance()->Load(mTexturePath, GL_LINEAR); // bodies with the same image share it
+	}
+	return mTexture.get();
+}
+
 void Planet::update(float time)
 {
 	// update the current orbit and rotation of the planet
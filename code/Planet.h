@@ -11,7 +11,8 @@ private:
 	static constexpr float defaultOrbit = 0.0f;
 
 	std::shared_ptr<AssetPath> mPath;
-	std::unique_ptr<Texture> mTexture; // texture of the planet
+	std::string mTexturePath; // full path of the planets texture
+	std::shared_ptr<Texture> mTexture; // texture of the planet from the TextureCache, loaded on first use (bodies drawn from a texture array never load it)
 	const float mOrbitRadius; // radius of the orbit
 	const float mOrbitSpeed; // speed of the orbit
 	const float mRotationSpeed; // speed of the rotation
@@ -31,7 +32,9 @@ public:
 
 	void updateCenterOfOrbit(glm::vec3 center) { mCenterOfOrbit = center; } // update the center of orbit (used for moons, orbiting relative to a planet)
 	
-	Texture* getTexture() const { return mTexture.get(); } // returns the texture of the planet
+	Texture* getTexture(); // returns the texture of the planet
+
+	std::string const& getTexturePath() const { return mTexturePath; } // returns the full path of the planets texture
 
 	glm::mat4& getModel() { return mModel; } // returns the model matrix of the planet
 
@@ -0,0 +1,188 @@
+#include "ProgramCache.hpp"
+
+#include "DiskCache.hpp"
+#include "Log.h"
+#include "MappedFile.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+
+namespace ProgramCache
+{
+
+	//==================================================================================================================
+
+	static constexpr uint32_t Magic = 0x474F5250; // "PROG"
+
+	// enums of GL 4.1 and ARB_get_program_binary, the 3.3 loader does not define them
+	static constexpr GLenum ProgramBinaryRetrievableHint = 0x8257; // GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	static constexpr GLenum ProgramBinaryLength = 0x8741;          // GL_PROGRAM_BINARY_LENGTH
+	static constexpr GLenum NumProgramBinaryFormats = 0x87FE;      // GL_NUM_PROGRAM_BINARY_FORMATS
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t keyHash;
+		uint32_t format;
+		uint32_t size;
+	};
+
+	using GetProgramBinaryFunction = void (APIENTRYP)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	using ProgramBinaryFunction = void (APIENTRYP)(GLuint program, GLenum binaryFormat, void const* binary, GLsizei length);
+	using ProgramParameteriFunction = void (APIENTRYP)(GLuint program, GLenum name, GLint value);
+
+	struct Functions
+	{
+		GetProgramBinaryFunction getProgramBinary = nullptr;
+		ProgramBinaryFunction programBinary = nullptr;
+		ProgramParameteriFunction programParameteri = nullptr;
+	};
+
+	//==================================================================================================================
+
+	// entry points from the modern loader, or of the extension through GLFW, null ones when neither has them
+	static Functions const& Entries()
+	{
+		static Functions const functions = []()->Functions
+		{
+			Functions loaded{};
+#if defined(GL_VERSION_4_1)
+			if (GLAD_GL_VERSION_4_1)
+			{
+				loaded = { glGetProgramBinary, glProgramBinary, glProgramParameteri };
+			}
+#endif
+			if (loaded.getProgramBinary == nullptr && glfwExtensionSupported("GL_ARB_get_program_binary") == GLFW_TRUE)
+			{
+				loaded.getProgramBinary = reinterpret_cast<GetProgramBinaryFunction>(glfwGetProcAddress("glGetProgramBinary"));
+				loaded.programBinary = reinterpret_cast<ProgramBinaryFunction>(glfwGetProcAddress("glProgramBinary"));
+				loaded.programParameteri = reinterpret_cast<ProgramParameteriFunction>(glfwGetProcAddress("glProgramParameteri"));
+			}
+
+			// some drivers expose the functions without supporting a single binary format
+			GLint formats = 0;
+			if (loaded.getProgramBinary != nullptr)
+			{
+				glGetIntegerv(NumProgramBinaryFormats, &formats);
+			}
+			if (formats == 0 || loaded.programBinary == nullptr || loaded.programParameteri == nullptr)
+			{
+				return {};
+			}
+			return loaded;
+		}();
+		return functions;
+	}
+
+	//==================================================================================================================
+
+	static std::filesystem::path PathFor(std::string const& name, uint64_t const key)
+	{
+		return DiskCache::Directory("programs") / fmt::format("{}_{:016x}.bin", name, key);
+	}
+
+	//==================================================================================================================
+
+	bool IsSupported()
+	{
+		return Entries().getProgramBinary != nullptr;
+	}
+
+	//==================================================================================================================
+
+	uint64_t Key(std::vector<std::string> const& sources)
+	{
+		uint64_t hash = DiskCache::Hash(&Version, sizeof(Version));
+		for (std::string const& source : sources)
+		{
+			uint64_t const size = source.size(); // keeps sources that only differ in where one ends apart
+			hash = DiskCache::Hash(&size, sizeof(size), hash);
+			hash = DiskCache::Hash(source, hash);
+		}
+		for (GLenum const name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			auto const* const text = reinterpret_cast<char const*>(glGetString(name));
+			hash = DiskCache::Hash(text != nullptr ? std::string(text) : std::string(), hash);
+		}
+		return hash;
+	}
+
+	//==================================================================================================================
+
+	bool Load(GLuint const program, uint64_t const key, std::string const& name)
+	{
+		if (IsSupported() == false)
+		{
+			return false;
+		}
+
+		MappedFile const file(PathFor(name, key).string());
+		if (file.IsValid() == false || file.Size() < sizeof(Header))
+		{
+			return false;
+		}
+
+		Header header{};
+		std::memcpy(&header, file.Data(), sizeof(Header));
+		if (header.magic != Magic || header.version != Version || header.keyHash != key || file.Size() < sizeof(Header) + header.size)
+		{
+			return false;
+		}
+
+		Entries().programBinary(program, header.format, file.Data() + sizeof(Header), static_cast<GLsizei>(header.size));
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		return linked == GL_TRUE;
+	}
+
+	//==================================================================================================================
+
+	void PrepareLink(GLuint const program)
+	{
+		if (IsSupported())
+		{
+			Entries().programParameteri(program, ProgramBinaryRetrievableHint, GL_TRUE);
+		}
+	}
+
+	//==================================================================================================================
+
+	void Store(GLuint const program, uint64_t const key, std::string const& name)
+	{
+		if (IsSupported() == false)
+		{
+			return;
+		}
+
+		GLint length = 0;
+		glGetProgramiv(program, ProgramBinaryLength, &length);
+		if (length <= 0)
+		{
+			return;
+		}
+
+		std::vector<std::byte> blob(sizeof(Header) + static_cast<size_t>(length));
+		GLsizei written = 0;
+		GLenum format = 0;
+		Entries().getProgramBinary(program, length, &written, &format, blob.data() + sizeof(Header));
+		if (written <= 0)
+		{
+			Log::warning("Program cache skipped {}, the driver returned no binary", name);
+			return;
+		}
+
+		Header header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.keyHash = key;
+		header.format = format;
+		header.size = static_cast<uint32_t>(written);
+		std::memcpy(blob.data(), &header, sizeof(Header));
+		DiskCache::WriteFile(PathFor(name, key), blob.data(), sizeof(Header) + static_cast<size_t>(written));
+	}
+
+	//==================================================================================================================
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Versioned disk cache of linked program binaries, core since GL 4.1 and ARB_get_program_binary before.
+// Entries are keyed by the sources of the stages and the driver strings, so an edited shader or another driver misses
+// and the program is compiled from source again. Binaries are only valid for the driver that wrote them, the driver
+// may still reject one, which counts as a miss.
+namespace ProgramCache
+{
+	// Bump whenever the file layout changes
+	inline static constexpr uint32_t Version = 1;
+
+	// Whether the context can read and load program binaries at all, needs a current context
+	[[nodiscard]]
+	bool IsSupported();
+
+	// Hash of the sources in order, with the vendor, renderer and version strings of the context
+	[[nodiscard]]
+	uint64_t Key(std::vector<std::string> const& sources);
+
+	// Loads the cached binary into program and reports whether it linked, name only names the cache file
+	[[nodiscard]]
+	bool Load(GLuint program, uint64_t key, std::string const& name);
+
+	// Asks the driver to keep the binary of program, call before linking it
+	void PrepareLink(GLuint program);
+
+	// Writes the binary of the linked program for the next run
+	void Store(GLuint program, uint64_t key, std::string const& name);
+}
@@ -0,0 +1,118 @@
+#include "RenderQueue.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+
+//======================================================================================================================
+
+static uint64_t DepthBits(float const depth)
+{
+	float const clamped = depth > 0.0f ? depth : 0.0f; // NaN and -0 compare false, so they map to 0 as well
+	uint32_t bits = 0;
+	std::memcpy(&bits, &clamped, sizeof(bits));
+	return bits;
+}
+
+//======================================================================================================================
+
+uint64_t SortKey::Opaque(uint32_t const pipeline, uint32_t const material, uint32_t const mesh, float const depth)
+{
+	assert(pipeline < MaxPipelines && material < MaxMaterials && mesh < MaxMeshes);
+	return static_cast<uint64_t>(Pass::Opaque) << 60
+		| static_cast<uint64_t>(pipeline) << 52
+		| static_cast<uint64_t>(material) << 40
+		| static_cast<uint64_t>(mesh) << 32
+		| DepthBits(depth);
+}
+
+//======================================================================================================================
+
+uint64_t SortKey::Transparent(float const depth, uint32_t const pipeline, uint32_t const material, uint32_t const mesh)
+{
+	assert(pipeline < MaxPipelines && material < MaxMaterials && mesh < MaxMeshes);
+	uint64_t const farFirst = ~DepthBits(depth) & 0xFFFFFFFFull;
+	return static_cast<uint64_t>(Pass::Transparent) << 60
+		| farFirst << 28
+		| static_cast<uint64_t>(pipeline) << 20
+		| static_cast<uint64_t>(material) << 8
+		| static_cast<uint64_t>(mesh);
+}
+
+//======================================================================================================================
+
+void RenderQueue::Clear()
+{
+	mKeys.clear();
+	mItems.clear();
+}
+
+//======================================================================================================================
+
+void RenderQueue::Truncate(size_t const count)
+{
+	if (count < mItems.size())
+	{
+		mKeys.resize(count);
+		mItems.resize(count);
+	}
+}
+
+//======================================================================================================================
+
+void RenderQueue::Push(uint64_t const key, uint32_t const item)
+{
+	mKeys.push_back(key);
+	mItems.push_back(item);
+}
+
+//======================================================================================================================
+
+void RenderQueue::Sort()
+{
+	size_t const count = mKeys.size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	// all eight digit histograms in one read of the keys
+	std::array<std::array<uint32_t, 256>, 8> histograms{};
+	for (uint64_t const key : mKeys)
+	{
+		for (size_t digit = 0; digit < 8; ++digit)
+		{
+			++histograms[digit][(key >> (digit * 8)) & 0xFF];
+		}
+	}
+
+	mScratchKeys.resize(count);
+	mScratchItems.resize(count);
+	for (size_t digit = 0; digit < 8; ++digit)
+	{
+		auto& histogram = histograms[digit];
+		if (histogram[(mKeys[0] >> (digit * 8)) & 0xFF] == count)
+		{
+			continue; // every key has the same digit
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : histogram)
+		{
+			uint32_t const bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint32_t const position = histogram[(mKeys[i] >> (digit * 8)) & 0xFF]++;
+			mScratchKeys[position] = mKeys[i];
+			mScratchItems[position] = mItems[i];
+		}
+		mKeys.swap(mScratchKeys);
+		mItems.swap(mScratchItems);
+	}
+}
+
+//======================================================================================================================
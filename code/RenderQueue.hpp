@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 64-bit sort keys, the most significant fields decide first:
+//
+//   opaque:      pass(4) | pipeline(8) | material(12) | mesh(8) | depth(32)    grouped by state, then front-to-back
+//   transparent: pass(4) | ~depth(32)  | pipeline(8)  | material(12) | mesh(8) back-to-front, then by state
+//
+// Depth is a non-negative distance from the camera, the bits of a non-negative float sort like the float itself
+namespace SortKey
+{
+	enum class Pass : uint32_t
+	{
+		Opaque = 0,
+		Transparent = 1,
+	};
+
+	inline static constexpr uint32_t MaxPipelines = 1u << 8;
+	inline static constexpr uint32_t MaxMaterials = 1u << 12;
+	inline static constexpr uint32_t MaxMeshes = 1u << 8;
+
+	[[nodiscard]]
+	uint64_t Opaque(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+	[[nodiscard]]
+	uint64_t Transparent(float depth, uint32_t pipeline, uint32_t material, uint32_t mesh);
+
+	[[nodiscard]]
+	inline Pass PassOf(uint64_t const key) { return static_cast<Pass>(key >> 60); }
+}
+
+// Draw items ordered by their sort key. Items are referenced by an index into the caller's own item storage
+class RenderQueue
+{
+public:
+
+	void Clear();
+
+	void Push(uint64_t key, uint32_t item);
+
+	// Keeps the first count items in queue order
+	void Truncate(size_t count);
+
+	// Stable LSD radix sort, 8 bits per pass. Passes where every key has the same digit are skipped, so fields that
+	// do not vary in a frame cost nothing
+	void Sort();
+
+	[[nodiscard]]
+	size_t Size() const { return mItems.size(); }
+
+	[[nodiscard]]
+	bool Empty() const { return mItems.empty(); }
+
+	[[nodiscard]]
+	uint32_t Item(size_t const position) const { return mItems[position]; }
+
+	[[nodiscard]]
+	uint64_t Key(size_t const position) const { return mKeys[position]; }
+
+private:
+
+	std::vector<uint64_t> mKeys{};
+	std::vector<uint32_t> mItems{};
+	std::vector<uint64_t> mScratchKeys{};
+	std::vector<uint32_t> mScratchItems{};
+};
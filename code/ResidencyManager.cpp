@@ -0,0 +1,164 @@
+#include "ResidencyManager.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+//======================================================================================================================
+
+std::shared_ptr<ResidencyManager> ResidencyManager::Instance()
+{
+	std::shared_ptr<ResidencyManager> shared_ptr = _instance.lock();
+	if (shared_ptr == nullptr)
+	{
+		shared_ptr = std::make_shared<ResidencyManager>();
+		_instance = shared_ptr;
+	}
+	return shared_ptr;
+}
+
+//======================================================================================================================
+
+void ResidencyManager::Register(std::shared_ptr<StreamedTexture> const& texture)
+{
+	Entry& entry = mEntries[texture.get()];
+	entry.texture = texture;
+	entry.lastUsed = mFrame; // new textures get a chance to be drawn before counting as idle
+	entry.wanted = texture->TargetLevel();
+}
+
+//======================================================================================================================
+
+void ResidencyManager::Use(StreamedTexture const* const texture, float const screenSize)
+{
+	auto const found = mEntries.find(texture);
+	if (found == mEntries.end())
+	{
+		return;
+	}
+	Entry& entry = found->second;
+	if (entry.lastUsed != mFrame)
+	{
+		entry.lastUsed = mFrame;
+		entry.screenSize = 0.0f;
+	}
+	entry.screenSize = std::max(entry.screenSize, screenSize);
+}
+
+//======================================================================================================================
+
+int ResidencyManager::CoverageLevel(Entry const& entry, StreamedTexture const& texture) const
+{
+	int const lastLevel = texture.LevelCount() - 1;
+	if (mFrame - entry.lastUsed > IdleFrames)
+	{
+		// the level whose larger side fits IdleSize
+		int const largestSide = std::max(texture.Size().x, texture.Size().y);
+		int level = 0;
+		while ((largestSide >> level) > IdleSize && level < lastLevel)
+		{
+			++level;
+		}
+		return level;
+	}
+
+	// one texel per pixel, like the level the hardware samples
+	float const texelsPerPixel = static_cast<float>(texture.Size().x) / std::max(entry.screenSize, 1.0f);
+	int const level = static_cast<int>(std::floor(std::log2(std::max(texelsPerPixel, 1.0f))));
+	return std::clamp(level, 0, lastLevel);
+}
+
+//======================================================================================================================
+
+void ResidencyManager::Update()
+{
+	for (auto it = mEntries.begin(); it != mEntries.end();)
+	{
+		it = it->second.texture.expired() ? mEntries.erase(it) : std::next(it);
+	}
+
+	mOrder.clear();
+	size_t total = 0;
+	for (auto& [key, entry] : mEntries)
+	{
+		entry.texture.lock()->Update(); // textures that aren't drawn swap their storage here
+		entry.wanted = CoverageLevel(entry, *key);
+		total += key->ByteSize(entry.wanted);
+		mOrder.push_back(&entry);
+	}
+
+	// least important first: least recently drawn, then covering the least of the screen
+	std::sort(mOrder.begin(), mOrder.end(), [](Entry const* a, Entry const* b)->bool
+	{
+		return a->lastUsed != b->lastUsed ? a->lastUsed < b->lastUsed : a->screenSize < b->screenSize;
+	});
+
+	// drop a level at a time from the least important textures until the wanted levels fit
+	bool dropped = true;
+	while (total > mBudget && dropped)
+	{
+		dropped = false;
+		for (Entry* entry : mOrder)
+		{
+			StreamedTexture const& texture = *entry->texture.lock();
+			if (entry->wanted + 1 < texture.LevelCount())
+			{
+				total -= texture.ByteSize(entry->wanted) - texture.ByteSize(entry->wanted + 1);
+				entry->wanted++;
+				dropped = true;
+				if (total <= mBudget)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	// textures the budget shrinks go first to free memory, then the most important ones stream in
+	size_t targetTotal = 0;
+	for (auto const& [key, entry] : mEntries)
+	{
+		targetTotal += key->ByteSize(key->TargetLevel());
+	}
+	bool const overBudget = targetTotal > mBudget;
+
+	size_t changes = 0;
+	for (auto it = mOrder.begin(); it != mOrder.end() && changes < ChangesPerFrame; ++it)
+	{
+		Entry const& entry = **it;
+		std::shared_ptr<StreamedTexture> const texture = entry.texture.lock();
+		bool const idle = mFrame - entry.lastUsed > IdleFrames;
+		bool const streaming = texture->TargetLevel() != texture->FirstLevel();
+		if (streaming == false && entry.wanted > texture->TargetLevel() && (overBudget || idle))
+		{
+			texture->StreamFrom(entry.wanted);
+			changes++;
+		}
+	}
+	for (auto it = mOrder.rbegin(); it != mOrder.rend() && changes < ChangesPerFrame; ++it)
+	{
+		Entry const& entry = **it;
+		std::shared_ptr<StreamedTexture> const texture = entry.texture.lock();
+		bool const streaming = texture->TargetLevel() != texture->FirstLevel();
+		if (streaming == false && entry.wanted < texture->TargetLevel())
+		{
+			texture->StreamFrom(entry.wanted);
+			changes++;
+		}
+	}
+
+	++mFrame;
+}
+
+//======================================================================================================================
+
+size_t ResidencyManager::ByteSize() const
+{
+	size_t size = 0;
+	for (auto const& [key, entry] : mEntries)
+	{
+		size += key->ByteSize();
+	}
+	return size;
+}
+
+//======================================================================================================================
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "StreamedTexture.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Keeps the streamed textures within a video memory budget. The renderer reports the textures it draws each frame
+// with the screen size they cover, and every texture is given the first mip level that coverage needs. Textures not
+// drawn for a while keep only their small levels. When the wanted levels don't fit the budget, the least recently
+// drawn textures, then the ones covering the least, fall back to coarser levels.
+//
+// Usage per frame on the GL thread: Use() for the drawn textures, then Update()
+class ResidencyManager
+{
+public:
+
+	static constexpr size_t DefaultBudget = 256 * 1024 * 1024;
+	static constexpr uint64_t IdleFrames = 300;  // frames without a draw until a texture counts as idle
+	static constexpr int IdleSize = 256;         // largest side of the levels an idle texture keeps
+	static constexpr size_t ChangesPerFrame = 2; // restreams started per frame, each one streams the whole texture
+
+	// GL thread only, like every use of the instance
+	static std::shared_ptr<ResidencyManager> Instance();
+
+	explicit ResidencyManager(size_t budget = DefaultBudget) : mBudget(budget) {}
+
+	// Starts managing the texture, it stays managed until it is destroyed
+	void Register(std::shared_ptr<StreamedTexture> const& texture);
+
+	// The texture is drawn this frame, screenSize is how many pixels its full width would cover on screen
+	void Use(StreamedTexture const* texture, float screenSize);
+
+	// Picks the first level of every texture and starts streaming the ones that change
+	void Update();
+
+	void SetBudget(size_t const budget) { mBudget = budget; }
+
+	[[nodiscard]]
+	size_t Budget() const { return mBudget; }
+
+	// Video memory of the managed textures, the storage being streamed in included
+	[[nodiscard]]
+	size_t ByteSize() const;
+
+	[[nodiscard]]
+	size_t TextureCount() const { return mEntries.size(); }
+
+private:
+
+	struct Entry
+	{
+		std::weak_ptr<StreamedTexture> texture{};
+		uint64_t lastUsed = 0;
+		float screenSize = 0.0f; // the largest this frame, or when last drawn
+		int wanted = 0;
+	};
+
+	[[nodiscard]]
+	int CoverageLevel(Entry const& entry, StreamedTexture const& texture) const;
+
+	inline static std::weak_ptr<ResidencyManager> _instance{};
+
+	size_t mBudget;
+	uint64_t mFrame = 1;
+	std::unordered_map<StreamedTexture const*, Entry> mEntries{};
+	std::vector<Entry*> mOrder{};
+};
@@ -15,15 +15,37 @@ Shader::Shader(const std::string& path, GLenum type)
 	, type(type)
 	, path(path)
 {
-	if (!compile()) {
+	std::string source;
+	if (!readSource(path, source) || !compile(source)) {
 		throw std::runtime_error("Shader did not compile");
 	}
 }
 
-bool Shader::compile() {
+Shader::Shader(const std::string& path, GLenum type, const std::string& source)
+	: shaderID(type)
+	, type(type)
+	, path(path)
+{
+	if (!compile(source)) {
+		throw std::runtime_error("Shader did not compile");
+	}
+}
+
+Shader::Shader(GLenum type, const std::string& path)
+	: shaderID(type)
+	, type(type)
+	, path(path)
+{
+}
+
+Shader Shader::submit(const std::string& path, GLenum type, const std::string& source) {
+	Shader shader(type, path);
+	shader.submitSource(source);
+	return shader;
+}
+
+bool Shader::readSource(const std::string& path, std::string& source) {
 
-	// read shader source
-	std::string sourceString;
 	std::ifstream file;
 
 	// ensure ifstream objects can throw exceptions:
@@ -40,18 +62,31 @@ bool Shader::compile() {
 		file.close();
 
 		// convert stream into string
-		sourceString = sourceStream.str();
+		source = sourceStream.str();
 	}
 	catch (std::ifstream::failure &e) {
 		Log::error("SHADER reading {}:\n{}", path, strerror(errno));
 		return false;
 	}
-	const GLchar* sourceCode = sourceString.c_str();
+	return true;
+}
+
+void Shader::submitSource(const std::string& source) {
 
+	const GLchar* sourceCode = source.c_str();
 
 	// compile shader
 	glShaderSource(shaderID, 1, &sourceCode, NULL);
 	glCompileShader(shaderID);
+}
+
+bool Shader::compile(const std::string& source) {
+
+	submitSource(source);
+	return checkCompileStatus();
+}
+
+bool Shader::checkCompileStatus() const {
 
 	// check for errors
 	GLint success;
@@ -13,6 +13,13 @@ class Shader {
 public:
 	Shader(const std::string& path, GLenum type);
 
+	// Compiles source already read from path, the path is kept for the logs
+	Shader(const std::string& path, GLenum type, const std::string& source);
+
+	// Submits source without waiting for the compile, its errors are only logged by checkCompileStatus. Lets the
+	// driver compile in the background while the program links
+	static Shader submit(const std::string& path, GLenum type, const std::string& source);
+
 	// Because we're using the ShaderHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -24,14 +31,23 @@ public:
 	std::string getPath() const { return path; }
 	GLenum getType() const { return type; }
 
+	// Reads the source at path, logs and returns false if it cannot be read
+	static bool readSource(const std::string& path, std::string& source);
+
+	// Waits for the compile, logs its errors and returns whether it succeeded
+	bool checkCompileStatus() const;
+
 	void friend attach(ShaderProgram& sp, Shader& s);
 
 private:
+	Shader(GLenum type, const std::string& path);
+
 	ShaderHandle shaderID;
 	GLenum type;
 
 	std::string path;
 
-	bool compile();
+	bool compile(const std::string& source);
+	void submitSource(const std::string& source);
 };
 
@@ -1,22 +1,70 @@
 #include "ShaderProgram.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
 
 #include "AssetPath.h"
 #include "Log.h"
+#include "ParallelCompile.hpp"
+#include "ProgramCache.hpp"
+#include "ShaderSource.hpp"
 
-ShaderProgram::ShaderProgram(const std::string &vertexPath,
-                             const std::string &fragmentPath)
+#include <filesystem>
+
+ShaderProgram::ShaderProgram(const std::string &vertexFile,
+                             const std::string &fragmentFile,
+                             std::vector<std::string> programDefines)
+    : ShaderProgram(vertexFile, fragmentFile, std::move(programDefines), true) {}
+
+std::unique_ptr<ShaderProgram>
+ShaderProgram::buildAsync(const std::string &vertexFile,
+                          const std::string &fragmentFile,
+                          std::vector<std::string> programDefines) {
+  return std::unique_ptr<ShaderProgram>(new ShaderProgram(vertexFile, fragmentFile, std::move(programDefines), false));
+}
+
+ShaderProgram::ShaderProgram(const std::string &vertexFile,
+                             const std::string &fragmentFile,
+                             std::vector<std::string> programDefines,
+                             bool wait)
     : programID(),
-      vertex(AssetPath::Instance()->Get(vertexPath), GL_VERTEX_SHADER),
-      fragment(AssetPath::Instance()->Get(fragmentPath), GL_FRAGMENT_SHADER) {
-  attach(*this, vertex);
-  attach(*this, fragment);
+      vertexPath(AssetPath::Instance()->Get(vertexFile)),
+      fragmentPath(AssetPath::Instance()->Get(fragmentFile)),
+      defines(std::move(programDefines)) {
+  std::string vertexSource;
+  std::string fragmentSource;
+  if (!ShaderSource::Load(vertexPath, defines, vertexSource) || !ShaderSource::Load(fragmentPath, defines, fragmentSource)) {
+    throw std::runtime_error("Shader did not compile");
+  }
+
+  // the binary linked by an earlier run skips compiling and linking the stages, the defines are part of the sources
+  cacheKey = ProgramCache::Key({ vertexSource, fragmentSource });
+  cacheName = std::filesystem::path(vertexPath).stem().string() + '_' +
+              std::filesystem::path(fragmentPath).stem().string();
+  if (ProgramCache::Load(programID, cacheKey, cacheName)) {
+    Log::info("SHADER_PROGRAM loaded {} + {} from the program cache", vertexPath, fragmentPath);
+    reflectUniforms();
+    status = Status::Linked;
+    return;
+  }
+  programID = ShaderProgramHandle(); // a rejected binary may leave the program unusable
+
+  if (wait) {
+    vertex.emplace(vertexPath, GL_VERTEX_SHADER, vertexSource);
+    fragment.emplace(fragmentPath, GL_FRAGMENT_SHADER, fragmentSource);
+  } else {
+    // nothing is queried until the link is done, so the driver is free to compile both stages in the background
+    vertex.emplace(Shader::submit(vertexPath, GL_VERTEX_SHADER, vertexSource));
+    fragment.emplace(Shader::submit(fragmentPath, GL_FRAGMENT_SHADER, fragmentSource));
+  }
+  attach(*this, *vertex);
+  attach(*this, *fragment);
+  ProgramCache::PrepareLink(programID);
   glLinkProgram(programID);
 
-  if (!checkAndLogLinkSuccess()) {
+  if (wait && finish() != Status::Linked) {
     glDeleteProgram(programID);
     throw std::runtime_error("Shaders did not link.");
   }
@@ -26,7 +74,7 @@ bool ShaderProgram::recompile() {
 
   try {
     // Try to create a new program
-    ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
+    ShaderProgram newProgram(vertexPath, fragmentPath, defines);
     *this = std::move(newProgram);
     return true;
   } catch (std::runtime_error &e) {
@@ -35,6 +83,33 @@ bool ShaderProgram::recompile() {
   }
 }
 
+ShaderProgram::Status ShaderProgram::poll() {
+  if (status == Status::Building && ParallelCompile::IsComplete(programID)) {
+    finishLink();
+  }
+  return status;
+}
+
+ShaderProgram::Status ShaderProgram::finish() {
+  if (status == Status::Building) {
+    finishLink();
+  }
+  return status;
+}
+
+void ShaderProgram::finishLink() {
+  // both stages log their errors before the link does
+  bool const vertexCompiled = vertex->checkCompileStatus();
+  bool const fragmentCompiled = fragment->checkCompileStatus();
+  if (!vertexCompiled || !fragmentCompiled || !checkAndLogLinkSuccess()) {
+    status = Status::Failed;
+    return;
+  }
+  ProgramCache::Store(programID, cacheKey, cacheName);
+  reflectUniforms();
+  status = Status::Linked;
+}
+
 void attach(ShaderProgram &sp, Shader &s) {
   glAttachShader(sp.programID, s.shaderID);
 }
@@ -50,12 +125,66 @@ bool ShaderProgram::checkAndLogLinkSuccess() const {
     std::vector<char> log(logLength);
     glGetProgramInfoLog(programID, logLength, NULL, log.data());
 
-    Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertex.getPath(),
-               fragment.getPath(), log.data());
+    Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertexPath,
+               fragmentPath, log.data());
     return false;
   } else {
     Log::info("SHADER_PROGRAM successfully compiled and linked {} + {}",
-              vertex.getPath(), fragment.getPath());
+              vertexPath, fragmentPath);
     return true;
   }
 }
+
+GLint ShaderProgram::uniformLocation(UniformHandle handle) const {
+  auto const found = uniformLocations.find(handle.hash);
+  return found != uniformLocations.end() ? found->second : -1;
+}
+
+GLuint ShaderProgram::uniformBlockIndex(UniformHandle handle) const {
+  auto const found = uniformBlockIndices.find(handle.hash);
+  return found != uniformBlockIndices.end() ? found->second : GL_INVALID_INDEX;
+}
+
+void ShaderProgram::reflectUniforms() {
+  GLint count = 0;
+  GLint maxLength = 0;
+  glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::vector<char> name(static_cast<size_t>(std::max(maxLength, 1)));
+
+  for (GLint i = 0; i < count; i++) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(programID, static_cast<GLuint>(i), maxLength, &length, &size, &type, name.data());
+
+    // members of uniform blocks have no location
+    GLint const location = glGetUniformLocation(programID, name.data());
+    if (location < 0) {
+      continue;
+    }
+
+    // arrays are reported as "name[0]", they are looked up by their plain name
+    std::string_view uniformName(name.data(), static_cast<size_t>(length));
+    if (uniformName.size() > 3 && uniformName.substr(uniformName.size() - 3) == "[0]") {
+      uniformName.remove_suffix(3);
+    }
+
+    if (!uniformLocations.emplace(UniformHandle(uniformName).hash, location).second) {
+      Log::error("SHADER_PROGRAM uniform name hash collision on {}", uniformName);
+    }
+  }
+
+  glGetProgramiv(programID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+  glGetProgramiv(programID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+  name.resize(static_cast<size_t>(std::max(maxLength, 1)));
+
+  for (GLint i = 0; i < count; i++) {
+    GLsizei length = 0;
+    glGetActiveUniformBlockName(programID, static_cast<GLuint>(i), maxLength, &length, name.data());
+    std::string_view const blockName(name.data(), static_cast<size_t>(length));
+    if (!uniformBlockIndices.emplace(UniformHandle(blockName).hash, static_cast<GLuint>(i)).second) {
+      Log::error("SHADER_PROGRAM uniform block name hash collision on {}", blockName);
+    }
+  }
+}
@@ -3,17 +3,51 @@
 #include "Shader.h"
 
 #include "GLHandles.h"
+#include "GLState.hpp"
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Precomputed hash of a uniform or uniform block name. Create handles once, e.g. as constexpr globals, so setting a
+// uniform is a hash table lookup and never hashes or compares strings
+struct UniformHandle
+{
+	uint64_t hash = 0;
+
+	constexpr UniformHandle() = default;
+
+	constexpr explicit UniformHandle(std::string_view name)
+	{
+		// FNV-1a
+		hash = 14695981039346656037ull;
+		for (char const c : name)
+		{
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+		}
+	}
+};
 
 
 class ShaderProgram {
 
 public:
-	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+	enum class Status { Building, Linked, Failed };
+
+	// Both stages are preprocessed by ShaderSource::Load, defines are added to both
+	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, std::vector<std::string> defines = {});
+
+	// Submits the stages and the link without waiting for the driver, poll() or finish() the program before using it.
+	// Only throws when a source cannot be read, compile and link errors are logged and leave it Failed
+	static std::unique_ptr<ShaderProgram> buildAsync(const std::string& vertexPath, const std::string& fragmentPath,
+		std::vector<std::string> defines = {});
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -23,7 +57,26 @@ public:
 
 	// Public interface
 	bool recompile();
-	void use() const { glUseProgram(programID); }
+
+	// Finishes the build once the driver is done with it, never blocks. Without ParallelCompile it stays Building
+	// until finish()
+	Status poll();
+	// Finishes the build, waits for the driver if it is not done yet
+	Status finish();
+	Status getStatus() const { return status; }
+
+	void use() const { GLState::UseProgram(programID); }
+
+	// Reflected at link time, -1 / GL_INVALID_INDEX if the program has no such active uniform or block
+	GLint uniformLocation(UniformHandle handle) const;
+	GLuint uniformBlockIndex(UniformHandle handle) const;
+
+	// Set a uniform of this program, the program has to be in use
+	void setUniform(UniformHandle handle, GLint value) const { glUniform1i(uniformLocation(handle), value); }
+	void setUniform(UniformHandle handle, GLfloat value) const { glUniform1f(uniformLocation(handle), value); }
+	void setUniform(UniformHandle handle, glm::vec3 const& value) const { glUniform3fv(uniformLocation(handle), 1, &value.x); }
+	void setUniform(UniformHandle handle, glm::vec4 const& value) const { glUniform4fv(uniformLocation(handle), 1, &value.x); }
+	void setUniform(UniformHandle handle, glm::mat4 const& value) const { glUniformMatrix4fv(uniformLocation(handle), 1, GL_FALSE, &value[0].x); }
 
 	void friend attach(ShaderProgram& sp, Shader& s);
 
@@ -32,10 +85,29 @@ public:
 	}
 
 private:
+	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, std::vector<std::string> defines,
+		bool wait);
+
 	ShaderProgramHandle programID;
+	Status status = Status::Building;
+
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::vector<std::string> defines;
+
+	// where the linked binary is stored in the ProgramCache
+	uint64_t cacheKey = 0;
+	std::string cacheName;
+
+	// compiled stages, not created when the program is loaded from the ProgramCache
+	std::optional<Shader> vertex;
+	std::optional<Shader> fragment;
 
-	Shader vertex;
-	Shader fragment;
+	// active uniforms and uniform blocks keyed by UniformHandle::hash
+	std::unordered_map<uint64_t, GLint> uniformLocations;
+	std::unordered_map<uint64_t, GLuint> uniformBlockIndices;
 
 	bool checkAndLogLinkSuccess() const;
+	void finishLink();
+	void reflectUniforms();
 };
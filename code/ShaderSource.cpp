@@ -0,0 +1,104 @@
+#include "ShaderSource.hpp"
+
+#include "Log.h"
+#include "Shader.h"
+
+#include <filesystem>
+#include <set>
+#include <sstream>
+
+namespace ShaderSource
+{
+
+	//==================================================================================================================
+
+	static constexpr int MaxIncludeDepth = 16;
+
+	//==================================================================================================================
+
+	// the quoted file of an #include line, empty for every other line
+	static std::string IncludedFile(std::string const& line)
+	{
+		size_t const start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			return {};
+		}
+		size_t const open = line.find('"', start + 8);
+		size_t const close = open == std::string::npos ? open : line.find('"', open + 1);
+		if (close == std::string::npos)
+		{
+			return {};
+		}
+		return line.substr(open + 1, close - open - 1);
+	}
+
+	//==================================================================================================================
+
+	static bool Expand(std::filesystem::path const& path, std::set<std::filesystem::path>& included, int const depth, std::string& output)
+	{
+		std::string text;
+		if (Shader::readSource(path.string(), text) == false)
+		{
+			return false;
+		}
+
+		std::istringstream lines(text);
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			std::string const file = IncludedFile(line);
+			if (file.empty())
+			{
+				output += line;
+				output += '\n';
+				continue;
+			}
+
+			std::filesystem::path const includePath = (path.parent_path() / file).lexically_normal();
+			if (depth >= MaxIncludeDepth)
+			{
+				Log::error("SHADER including {} from {}: nested too deep", includePath.string(), path.string());
+				return false;
+			}
+			if (included.insert(includePath).second && Expand(includePath, included, depth + 1, output) == false)
+			{
+				Log::error("SHADER including {} from {}", includePath.string(), path.string());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//==================================================================================================================
+
+	bool Load(std::string const& path, std::vector<std::string> const& defines, std::string& source)
+	{
+		std::set<std::filesystem::path> included{ std::filesystem::path(path).lexically_normal() };
+		std::string expanded;
+		if (Expand(path, included, 0, expanded) == false)
+		{
+			return false;
+		}
+
+		std::string definitions;
+		for (std::string const& define : defines)
+		{
+			definitions += "#define " + define + '\n';
+		}
+
+		// nothing but comments may come before #version
+		size_t const version = expanded.find("#version");
+		size_t const lineEnd = version == std::string::npos ? std::string::npos : expanded.find('\n', version);
+		if (lineEnd == std::string::npos)
+		{
+			Log::error("SHADER {} has no #version line", path);
+			return false;
+		}
+		source = expanded.substr(0, lineEnd + 1) + definitions + expanded.substr(lineEnd + 1);
+		return true;
+	}
+
+	//==================================================================================================================
+
+}
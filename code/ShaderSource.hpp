@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Preprocessing of shader sources before they are handed to the driver
+namespace ShaderSource
+{
+	// Reads the shader at path into source. Lines of the form #include "file" are replaced by that file, resolved
+	// relative to the including one and included once. Every name in defines gets a #define line right after #version,
+	// so one source compiles into variants that only contain the code they need. Logs and returns false on errors
+	[[nodiscard]]
+	bool Load(std::string const& path, std::vector<std::string> const& defines, std::string& source);
+}
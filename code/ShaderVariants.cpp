@@ -0,0 +1,199 @@
+#include "ShaderVariants.hpp"
+
+#include "Log.h"
+#include "ParallelCompile.hpp"
+
+#include <bitset>
+#include <cassert>
+#include <stdexcept>
+
+//======================================================================================================================
+
+ShaderVariants::ShaderVariants(
+	std::string vertexPath,
+	std::string fragmentPath,
+	std::vector<std::string> featureNames,
+	uint32_t const essentialFeatures,
+	std::function<void(ShaderProgram&)> setup
+)
+	: mVertexPath(std::move(vertexPath))
+	, mFragmentPath(std::move(fragmentPath))
+	, mFeatureNames(std::move(featureNames))
+	, mEssentialFeatures(essentialFeatures)
+	, mSetup(std::move(setup))
+	, mParallel(ParallelCompile::IsSupported()) // sets the compiler threads before the first variant is submitted
+{
+}
+
+//======================================================================================================================
+
+std::optional<uint32_t> ShaderVariants::Resolve(uint32_t const features)
+{
+	assert(features >> mFeatureNames.size() == 0);
+	Variant& variant = mVariants[features];
+	if (variant.program != nullptr)
+	{
+		return features;
+	}
+	if (variant.pending == nullptr && variant.failed == false)
+	{
+		Start(features, variant);
+	}
+
+	// a subset of the features draws close enough for the few frames the build takes
+	uint32_t const essential = features & mEssentialFeatures;
+	uint32_t fallback = 0;
+	size_t fallbackCount = 0;
+	bool found = false;
+	for (auto const& [mask, other] : mVariants)
+	{
+		size_t const count = std::bitset<32>(mask).count();
+		if (other.program != nullptr && (mask & ~features) == 0 && (mask & mEssentialFeatures) == essential &&
+			(found == false || count > fallbackCount))
+		{
+			fallback = mask;
+			fallbackCount = count;
+			found = true;
+		}
+	}
+	if (found)
+	{
+		return fallback;
+	}
+
+	// nothing can stand in, the first draws of these features wait for it. A failed build was logged by Finish
+	if (variant.pending != nullptr)
+	{
+		Finish(features, variant);
+	}
+	if (variant.program == nullptr)
+	{
+		return std::nullopt;
+	}
+	return features;
+}
+
+//======================================================================================================================
+
+ShaderProgram& ShaderVariants::Get(uint32_t const variant)
+{
+	return *mVariants.at(variant).program;
+}
+
+//======================================================================================================================
+
+void ShaderVariants::Update()
+{
+	bool waited = false;
+	for (auto& [features, variant] : mVariants)
+	{
+		if (variant.pending == nullptr)
+		{
+			continue;
+		}
+		if (variant.pending->poll() == ShaderProgram::Status::Building)
+		{
+			if (mParallel || waited)
+			{
+				continue;
+			}
+			waited = true;
+		}
+		Finish(features, variant);
+	}
+}
+
+//======================================================================================================================
+
+void ShaderVariants::Reload()
+{
+	for (auto& [features, variant] : mVariants)
+	{
+		variant.failed = false;
+		Start(features, variant);
+	}
+}
+
+//======================================================================================================================
+
+size_t ShaderVariants::Count() const
+{
+	size_t count = 0;
+	for (auto const& [features, variant] : mVariants)
+	{
+		count += variant.program != nullptr ? 1 : 0;
+	}
+	return count;
+}
+
+//======================================================================================================================
+
+size_t ShaderVariants::PendingCount() const
+{
+	size_t count = 0;
+	for (auto const& [features, variant] : mVariants)
+	{
+		count += variant.pending != nullptr ? 1 : 0;
+	}
+	return count;
+}
+
+//======================================================================================================================
+
+void ShaderVariants::Start(uint32_t const features, Variant& variant)
+{
+	std::vector<std::string> defines{};
+	for (size_t feature = 0; feature < mFeatureNames.size(); ++feature)
+	{
+		if ((features >> feature & 1u) != 0)
+		{
+			defines.push_back(mFeatureNames[feature]);
+		}
+	}
+
+	try
+	{
+		variant.pending = ShaderProgram::buildAsync(mVertexPath, mFragmentPath, std::move(defines));
+	}
+	catch (std::runtime_error const&)
+	{
+		Log::warn("SHADER_PROGRAM could not read the sources of variant {}", Name(features));
+		variant.pending.reset();
+		variant.failed = true;
+	}
+}
+
+//======================================================================================================================
+
+void ShaderVariants::Finish(uint32_t const features, Variant& variant)
+{
+	std::unique_ptr<ShaderProgram> program = std::move(variant.pending);
+	if (program->finish() != ShaderProgram::Status::Linked)
+	{
+		Log::warn("SHADER_PROGRAM variant {} failed, {}", Name(features),
+			variant.program != nullptr ? "keeping its previous version" : "its draws use a fallback or are skipped");
+		variant.failed = true;
+		return;
+	}
+
+	program->use();
+	mSetup(*program);
+	variant.program = std::move(program);
+}
+
+//======================================================================================================================
+
+std::string ShaderVariants::Name(uint32_t const features) const
+{
+	std::string name{};
+	for (size_t feature = 0; feature < mFeatureNames.size(); ++feature)
+	{
+		if ((features >> feature & 1u) != 0)
+		{
+			name += name.empty() ? mFeatureNames[feature] : '+' + mFeatureNames[feature];
+		}
+	}
+	return name.empty() ? "<none>" : name;
+}
+
+//======================================================================================================================
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Programs of one vertex/fragment pair, one per combination of feature defines. A feature mask selects the variant,
+// bit i defines featureNames[i], and every variant is compiled on first use. Across runs the ProgramCache keeps them.
+// New variants build in the background, until one is ready its draws use a ready variant with fewer features
+class ShaderVariants
+{
+public:
+
+	// setup runs once on every new variant while it is in use, e.g. to bind its samplers and uniform blocks.
+	// A fallback keeps the essential features of the variant it stands in for, those that change what it samples
+	ShaderVariants(std::string vertexPath, std::string fragmentPath, std::vector<std::string> featureNames,
+		uint32_t essentialFeatures, std::function<void(ShaderProgram&)> setup);
+
+	// The variant to draw the features with, starts building theirs if it is new. Until it is ready this is the
+	// ready variant with the most of the features and the same essential ones, without one it waits for the build.
+	// Empty when that build failed too, the draws of the features are skipped then
+	[[nodiscard]]
+	std::optional<uint32_t> Resolve(uint32_t features);
+
+	// A variant Resolve returned
+	[[nodiscard]]
+	ShaderProgram& Get(uint32_t variant);
+
+	// Adopts the variants the driver finished, call once a frame outside of rendering. Without ParallelCompile the
+	// driver cannot tell, then one build is waited for per call
+	void Update();
+
+	// Rebuilds every variant from source in the background, the current programs draw until theirs are ready
+	void Reload();
+
+	// Variants ready to draw
+	[[nodiscard]]
+	size_t Count() const;
+
+	// Variants still building
+	[[nodiscard]]
+	size_t PendingCount() const;
+
+private:
+
+	struct Variant
+	{
+		std::unique_ptr<ShaderProgram> program{}; // ready to draw
+		std::unique_ptr<ShaderProgram> pending{}; // building, replaces program once it is linked
+		bool failed = false; // the last build failed, it is not retried until Reload
+	};
+
+	void Start(uint32_t features, Variant& variant);
+	void Finish(uint32_t features, Variant& variant);
+	[[nodiscard]]
+	std::string Name(uint32_t features) const;
+
+	std::string mVertexPath;
+	std::string mFragmentPath;
+	std::vector<std::string> mFeatureNames;
+	uint32_t mEssentialFeatures = 0;
+	std::function<void(ShaderProgram&)> mSetup;
+	bool mParallel = false;
+	std::unordered_map<uint32_t, Variant> mVariants{};
+};
@@ -1,19 +1,169 @@
 #pragma once
 
 #include "Geometry.h"
+#include "ThreadPool.hpp"
 
+#include <glm/gtc/constants.hpp>
+
+#include <cstddef>
+
+// The sphere and ring generators produce indexed geometry. Sizes are known up front (see the *Count functions) so
+// the output can be written straight into caller-provided storage without any intermediate allocation.
+//
+// The Write* functions are templated on the output format. A format is any type with
+//     void Write(size_t index, Position const& position, Normal const& normal, UV const& uv) const;
+// SeparateArrays (the CPU_Geometry layout) is provided below.
 namespace ShapeGenerator
 {
-	// TODO
-	 [[nodiscard]]
-	CPU_Geometry Sphere(float radius, int slices, int stacks); // creates a sphere cpu geometry 
+	inline static constexpr Color DefaultColor{ 0.0f, 1.0f, 1.0f };
+
+	// Writes into separate position/color/normal/uv arrays
+	struct SeparateArrays
+	{
+		Position* positions;
+		Color* colors;
+		Normal* normals;
+		UV* uvs;
+
+		void Write(size_t const index, Position const& position, Normal const& normal, UV const& uv) const
+		{
+			positions[index] = position;
+			colors[index] = DefaultColor;
+			normals[index] = normal;
+			uvs[index] = uv;
+		}
+	};
+
+	// Sphere vertices form a (slices + 1) x (stacks + 1) grid, the last slice duplicates the first for the uv seam
+	[[nodiscard]]
+	constexpr size_t SphereVertexCount(int const slices, int const stacks)
+	{
+		return static_cast<size_t>(slices + 1) * static_cast<size_t>(stacks + 1);
+	}
+
+	[[nodiscard]]
+	constexpr size_t SphereIndexCount(int const slices, int const stacks)
+	{
+		return 6 * static_cast<size_t>(slices) * static_cast<size_t>(stacks);
+	}
+
+	// Ring vertices alternate outer/inner, the last pair duplicates the first for the uv seam
+	[[nodiscard]]
+	constexpr size_t RingVertexCount(int const resolution)
+	{
+		return 2 * static_cast<size_t>(resolution + 1);
+	}
+
+	[[nodiscard]]
+	constexpr size_t RingIndexCount(int const resolution)
+	{
+		return 6 * static_cast<size_t>(resolution);
+	}
+
+	// Writes the vertices of slices [firstSlice, lastSlice], lastSlice may be equal to slices.
+	// Vertex (slice, stack) is written at slice * (stacks + 1) + stack
+	template <typename Output>
+	void WriteSphereVertices(Output const& output, float const radius, int const slices, int const stacks, int const firstSlice, int const lastSlice)
+	{
+		for (int i = firstSlice; i <= lastSlice; i++)
+		{
+			float const u = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(slices);
+			float const cosU = glm::cos(u);
+			float const sinU = glm::sin(u);
+			float const uvX = static_cast<float>(i) / static_cast<float>(slices);
+
+			size_t const sliceStart = static_cast<size_t>(i) * static_cast<size_t>(stacks + 1);
+			for (int j = 0; j <= stacks; j++)
+			{
+				float const v = glm::pi<float>() * static_cast<float>(j) / static_cast<float>(stacks);
+				// revolve the point of a single half circle curve around the y axis
+				float const curveX = j == stacks ? 0.0f : glm::sin(v); // guarantee the section at the bottom
+				float const curveY = j == stacks ? -1.0f : glm::cos(v);
+
+				Normal const normal{ curveX * cosU, curveY, curveX * sinU };
+				UV const uv{ uvX, 1.0f - static_cast<float>(j) / static_cast<float>(stacks) };
+				output.Write(sliceStart + j, normal * radius, normal, uv);
+			}
+		}
+	}
 
-	// does the same as Sphere() but in opposite winding order so the textures can properly load on the inside of the sphere
-	CPU_Geometry BackgroundSphere(float radius, int slices, int stacks); 
+	template <typename Output>
+	void WriteSphereVertices(Output const& output, float const radius, int const slices, int const stacks)
+	{
+		WriteSphereVertices(output, radius, slices, stacks, 0, slices);
+	}
 
+	// Writes the indices of the quads between slices [firstSlice, lastSlice), quad (slice, stack) starts at
+	// 6 * (slice * stacks + stack)
+	inline void WriteSphereIndices(Index* indices, int const stacks, int const firstSlice, int const lastSlice)
+	{
+		Index const columnSize = static_cast<Index>(stacks + 1);
+		for (int i = firstSlice; i < lastSlice; i++)
+		{
+			Index* quad = indices + 6 * static_cast<size_t>(i) * static_cast<size_t>(stacks);
+			for (int j = 0; j < stacks; j++, quad += 6)
+			{
+				Index const topLeft = static_cast<Index>(i) * columnSize + static_cast<Index>(j);
+				Index const bottomLeft = topLeft + 1;
+				Index const bottomRight = topLeft + columnSize + 1;
+				Index const topRight = topLeft + columnSize;
+
+				quad[0] = topLeft; quad[1] = bottomRight; quad[2] = bottomLeft;
+				quad[3] = topLeft; quad[4] = topRight; quad[5] = bottomRight;
+			}
+		}
+	}
+
+	// Sphere size (in quads) from which Sphere() splits the work across the thread pool
+	inline static constexpr size_t ParallelQuadThreshold = 256 * 256;
+
+	// Writes a whole sphere. With a pool the slices are split into ranges that are generated concurrently into
+	// disjoint parts of the output, each vertex and index only depends on its slice/stack so the result is
+	// byte-identical to the serial path
+	template <typename Output>
+	void WriteSphere(Output const& output, Index* indices, float const radius, int const slices, int const stacks, ThreadPool* pool = nullptr)
+	{
+		auto const writeSlices = [&](int const firstSlice, int const endSlice)->void
+		{
+			// the seam column has no quads of its own, the last range writes it
+			WriteSphereVertices(output, radius, slices, stacks, firstSlice, endSlice == slices ? slices : endSlice - 1);
+			WriteSphereIndices(indices, stacks, firstSlice, endSlice);
+		};
+
+		if (pool == nullptr)
+		{
+			writeSlices(0, slices);
+			return;
+		}
+
+		// a few ranges per thread keeps the workers busy when some finish early
+		int const rangeCount = static_cast<int>(pool->ThreadCount() + 1) * 4;
+		pool->ParallelFor(0, slices, (slices + rangeCount - 1) / rangeCount, writeSlices);
+	}
+
+	template <typename Output>
+	void WriteRingVertices(Output const& output, float const radius, float const width, int const resolution)
+	{
+		Normal const normal{ 0.0f, 1.0f, 0.0f };
+		for (int i = 0; i <= resolution; i++)
+		{
+			// guarantee the end of the ring lands exactly on the start
+			float const u = i == resolution ? 0.0f : glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(resolution);
+			glm::vec3 const direction{ glm::cos(u), 0.0f, glm::sin(u) };
+			float const uvY = static_cast<float>(i) / static_cast<float>(resolution);
+
+			output.Write(2 * static_cast<size_t>(i), direction * (radius + width), normal, UV{ 1.0f, uvY }); // outer
+			output.Write(2 * static_cast<size_t>(i) + 1, direction * radius, normal, UV{ 0.0f, uvY }); // inner
+		}
+	}
+
+	void WriteRingIndices(Index* indices, int resolution);
+
+	[[nodiscard]]
+	CPU_Geometry Sphere(float radius, int slices, int stacks); // creates a sphere cpu geometry 
+
+	[[nodiscard]]
 	CPU_Geometry Ring(float radius, float width, int resolution); // creates a ring cpu geometry 
 
 	CPU_Geometry UnitCube();
-
-	std::vector<std::vector<glm::vec3>> GenerateSphere(float radius, int slices, int stacks); // creates a sphere with its positions
-};
\ No newline at end of file
+};
@@ -0,0 +1,259 @@
+#include "Skybox.hpp"
+
+#include "DiskCache.hpp"
+#include "GLState.hpp"
+#include "Log.h"
+#include "MipDiskCache.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+//======================================================================================================================
+
+namespace
+{
+	// cache names of the faces in GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order
+	constexpr char const* FaceNames[Skybox::FaceCount] = { "px", "nx", "py", "ny", "pz", "nz" };
+
+	// direction through s, t in [-1, 1] of a face, the inverse of the face selection in the GL spec
+	glm::vec3 FaceDirection(int const face, float const s, float const t)
+	{
+		switch (face)
+		{
+		case 0: return { 1.0f, -t, -s };
+		case 1: return { -1.0f, -t, s };
+		case 2: return { s, 1.0f, t };
+		case 3: return { s, -1.0f, -t };
+		case 4: return { s, -t, 1.0f };
+		default: return { -s, -t, -1.0f };
+		}
+	}
+
+	// bilinear sample of the equirectangular image in a direction, mapped like the background sphere did: the longitude
+	// atan2(z, x) across the image, +y at the top row. It wraps around horizontally and clamps at the poles
+	void SampleEquirect(unsigned char const* pixels, int const width, int const height, glm::vec3 const direction, float* color)
+	{
+		glm::vec3 const unit = glm::normalize(direction);
+		float u = std::atan2(unit.z, unit.x) / glm::two_pi<float>();
+		u = u < 0.0f ? u + 1.0f : u;
+		float const v = std::acos(std::clamp(unit.y, -1.0f, 1.0f)) / glm::pi<float>();
+
+		float const x = u * static_cast<float>(width) - 0.5f;
+		float const y = v * static_cast<float>(height) - 0.5f;
+		float const left = std::floor(x);
+		float const top = std::floor(y);
+		float const fx = x - left;
+		float const fy = y - top;
+		int const x0 = (static_cast<int>(left) % width + width) % width;
+		int const x1 = (x0 + 1) % width;
+		int const y0 = std::clamp(static_cast<int>(top), 0, height - 1);
+		int const y1 = std::clamp(static_cast<int>(top) + 1, 0, height - 1);
+
+		auto const texel = [&](int const tx, int const ty, int const channel)->float
+		{
+			size_t const index = (static_cast<size_t>(ty) * static_cast<size_t>(width) + static_cast<size_t>(tx)) * Skybox::Channels;
+			return static_cast<float>(pixels[index + static_cast<size_t>(channel)]);
+		};
+		for (int channel = 0; channel < Skybox::Channels; ++channel)
+		{
+			float const upper = texel(x0, y0, channel) + (texel(x1, y0, channel) - texel(x0, y0, channel)) * fx;
+			float const lower = texel(x0, y1, channel) + (texel(x1, y1, channel) - texel(x0, y1, channel)) * fx;
+			color[channel] = upper + (lower - upper) * fy;
+		}
+	}
+
+	// path the face is cached under, only its stem names the cache file
+	std::string FacePath(std::string const& path, int const face)
+	{
+		return std::filesystem::path(path).stem().string() + '_' + FaceNames[face];
+	}
+}
+
+//======================================================================================================================
+
+Skybox::Skybox(std::string const& path, int const faceSize)
+	: mPool(ThreadPool::Instance())
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	if (stbi_info(path.c_str(), &width, &height, &channels) == 0)
+	{
+		throw std::runtime_error("Failed to read texture data from file!");
+	}
+	mFaceSize = faceSize > 0 ? faceSize : std::max(width / 4, 1);
+
+	// corners of the faces filter across the edges instead of within each face
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	mFaces = mPool->Submit([pool = mPool.get(), path, size = mFaceSize, stopping = &mStopping]()->Faces
+	{
+		return LoadFaces(*pool, path, size, *stopping);
+	});
+}
+
+//======================================================================================================================
+
+Skybox::~Skybox()
+{
+	// the conversion reads mStopping and runs on mPool, both have to outlive it
+	mStopping = true;
+	if (mFaces.valid())
+	{
+		mFaces.wait();
+	}
+}
+
+//======================================================================================================================
+
+Skybox::Faces Skybox::LoadFaces(ThreadPool& pool, std::string const& path, int const faceSize, std::atomic<bool> const& stopping)
+{
+	Faces faces{};
+	uint64_t const sourceHash = MipDiskCache::SourceHash(path);
+	uint64_t const faceHash = DiskCache::Hash(&faceSize, sizeof(faceSize), sourceHash);
+	bool cached = sourceHash != 0;
+	for (int face = 0; face < FaceCount && cached; ++face)
+	{
+		faces[face] = MipDiskCache::Load(FacePath(path, face), faceHash, Channels);
+		cached = faces[face] != nullptr && faces[face]->levels[0].width == faceSize;
+	}
+	if (cached)
+	{
+		return faces;
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+
+	// not flipped, the rows of a face go down from t = -1 like the GL spec expects them
+	stbi_set_flip_vertically_on_load_thread(false);
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* const pixels = stbi_load(path.c_str(), &width, &height, &channels, Channels);
+	if (pixels == nullptr)
+	{
+		Log::error("Failed to read texture data from file: {}", path);
+		return {};
+	}
+
+	// every texel averages 2x2 samples, near the poles a texel of a face covers many of the image
+	size_t const faceBytes = static_cast<size_t>(faceSize) * static_cast<size_t>(faceSize) * Channels;
+	std::vector<unsigned char> converted(faceBytes * FaceCount);
+	pool.ParallelFor(0, FaceCount * faceSize, 16, [&](int const rowBegin, int const rowEnd)->void
+	{
+		if (stopping)
+		{
+			return; // the remaining rows are skipped, nothing is stored
+		}
+		float const scale = 2.0f / static_cast<float>(faceSize);
+		for (int row = rowBegin; row < rowEnd; ++row)
+		{
+			int const face = row / faceSize;
+			int const y = row % faceSize;
+			unsigned char* output = converted.data() + faceBytes * static_cast<size_t>(face) + static_cast<size_t>(y) * static_cast<size_t>(faceSize) * Channels;
+			for (int x = 0; x < faceSize; ++x, output += Channels)
+			{
+				float sum[Channels]{};
+				for (float const offsetY : { 0.25f, 0.75f })
+				{
+					for (float const offsetX : { 0.25f, 0.75f })
+					{
+						float sample[Channels]{};
+						float const s = (static_cast<float>(x) + offsetX) * scale - 1.0f;
+						float const t = (static_cast<float>(y) + offsetY) * scale - 1.0f;
+						SampleEquirect(pixels, width, height, FaceDirection(face, s, t), sample);
+						for (int channel = 0; channel < Channels; ++channel)
+						{
+							sum[channel] += sample[channel];
+						}
+					}
+				}
+				for (int channel = 0; channel < Channels; ++channel)
+				{
+					output[channel] = static_cast<unsigned char>(std::min(sum[channel] * 0.25f + 0.5f, 255.0f));
+				}
+			}
+		}
+	});
+	stbi_image_free(pixels);
+	if (stopping)
+	{
+		return {};
+	}
+
+	for (int face = 0; face < FaceCount; ++face)
+	{
+		std::shared_ptr<MipChain> chain = Mips::Build(converted.data() + faceBytes * static_cast<size_t>(face), faceSize, faceSize, Channels, pool);
+		if (sourceHash != 0)
+		{
+			MipDiskCache::Store(FacePath(path, face), faceHash, *chain);
+		}
+		faces[face] = std::move(chain);
+	}
+
+	auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	Log::info("Converted {} into {}x{} cubemap faces in {:.2f}s", std::filesystem::path(path).filename().string(), faceSize, faceSize, seconds);
+	return faces;
+}
+
+//======================================================================================================================
+
+void Skybox::Update()
+{
+	if (mFaces.valid() == false || mFaces.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	Faces const faces = mFaces.get();
+	if (std::any_of(faces.begin(), faces.end(), [](auto const& face)->bool { return face == nullptr; }))
+	{
+		return; // logged by LoadFaces, the sky stays empty
+	}
+
+	TextureStreamer::Target target{ GL_TEXTURE_CUBE_MAP, mTexture, 0, mFaceSize, mFaceSize, Channels, GL_RGB };
+	TextureStreamer::AllocateStorage(target, FaceCount, GL_LINEAR);
+	mAllocated = true;
+
+	auto const streamer = TextureStreamer::Instance();
+	for (int face = 0; face < FaceCount; ++face)
+	{
+		target.layer = face;
+		mTickets[face] = streamer->Load(faces[face], target);
+	}
+}
+
+//======================================================================================================================
+
+bool Skybox::IsResident() const
+{
+	return std::all_of(mTickets.begin(), mTickets.end(), [](auto const& ticket)->bool
+	{
+		return ticket != nullptr && ticket->IsResident();
+	});
+}
+
+//======================================================================================================================
+
+void Skybox::Bind(GLuint const unit) const
+{
+	GLState::BindTexture(unit, GL_TEXTURE_CUBE_MAP, mTexture);
+}
+
+//======================================================================================================================
+
+size_t Skybox::ByteSize() const
+{
+	return mAllocated ? Mips::ChainSize(mFaceSize, mFaceSize, Channels) * FaceCount : 0;
+}
+
+//======================================================================================================================
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "GLHandles.h"
+#include "MipChain.hpp"
+#include "TextureStreamer.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <string>
+
+class ThreadPool;
+
+// The star background as a mip-mapped cubemap, sampled by direction from a full-screen triangle at the far plane.
+// The equirectangular image is converted into faces on the ThreadPool, the faces are kept in the MipDiskCache so later
+// runs map them instead of decoding the image, then they stream in through the TextureStreamer. Nothing is drawn until
+// every face is resident.
+class Skybox
+{
+public:
+
+	static constexpr int FaceCount = 6;
+	static constexpr int Channels = 3;
+
+	// faceSize of 0 uses a quarter of the image width, which keeps the texel density at the centers of the faces
+	explicit Skybox(std::string const& path, int faceSize = 0);
+
+	// Stops a conversion that is still running and waits for it
+	~Skybox();
+
+	Skybox(Skybox const&) = delete;
+	Skybox& operator=(Skybox const&) = delete;
+
+	// Hands the converted faces to the TextureStreamer once they are done, call once per frame on the GL thread
+	void Update();
+
+	[[nodiscard]]
+	bool IsResident() const;
+
+	void Bind(GLuint unit) const;
+
+	[[nodiscard]]
+	int FaceSize() const { return mFaceSize; }
+
+	// Bytes of the allocated faces, 0 while converting
+	[[nodiscard]]
+	size_t ByteSize() const;
+
+private:
+
+	using Faces = std::array<std::shared_ptr<MipChain const>, FaceCount>;
+
+	// Faces of the image from the disk cache, or converted and stored for the next run. Null faces if it failed or
+	// stopping was set
+	static Faces LoadFaces(ThreadPool& pool, std::string const& path, int faceSize, std::atomic<bool> const& stopping);
+
+	std::shared_ptr<ThreadPool> mPool{}; // the conversion runs on it, kept until it is done
+	std::atomic<bool> mStopping = false;
+	TextureHandle mTexture{};
+	int mFaceSize = 0;
+	std::future<Faces> mFaces{};
+	std::array<std::shared_ptr<TextureStreamer::Ticket>, FaceCount> mTickets{};
+	bool mAllocated = false;
+};
@@ -1,20 +1,47 @@
 #include "SolarSystem.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
 
 #include "GLDebug.h"
+#include "GLState.hpp"
 #include "Log.h"
 
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include <imgui.h>
 
+#include <glm/gtc/constants.hpp>
+
+#include "DiskCache.hpp"
+#include "GeometryCache.hpp"
+#include "MeshLoader.hpp"
 #include "ShapeGenerator.hpp"
 
 // Step 1: Create a sphere with positions, indices, and uv values
 // Step 2: Create the solar system with sun, earth and moon
 // Step 3: Add cube map texture for background and
 
+// uniforms and uniform blocks of the basic shader
+namespace Uniforms
+{
+	constexpr UniformHandle LightColor{ "lightColor" };
+	constexpr UniformHandle LightPos{ "lightPos" };
+	constexpr UniformHandle ViewPos{ "viewPos" };
+	constexpr UniformHandle BaseDraw{ "baseDraw" };
+	constexpr UniformHandle BodyTextures{ "bodyTextures" };
+	constexpr UniformHandle NightMap{ "nightMapTexture" };
+	constexpr UniformHandle PageCache{ "pageCache" };
+	constexpr UniformHandle PageTable{ "pageTable" };
+	constexpr UniformHandle VirtualSize{ "virtualSize" };
+	constexpr UniformHandle LodBias{ "lodBias" };
+	constexpr UniformHandle Draws{ DrawBlock::Name };
+	constexpr UniformHandle Skybox{ "skybox" };
+	constexpr UniformHandle InverseViewProjection{ "inverseViewProjection" };
+}
+
 //======================================================================================================================
 
 SolarSystem::SolarSystem()
@@ -33,7 +60,7 @@ SolarSystem::SolarSystem()
 	ImGui_ImplOpenGL3_Init("#version 330 core");
 
 	glEnable(GL_MULTISAMPLE);
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST);
 	int samples = 0;
 	glGetIntegerv(GL_SAMPLES, &samples);
 	Log::info("MSAA Samples: {0}", samples);
@@ -47,18 +74,49 @@ SolarSystem::SolarSystem()
 
 	mWindow->setCallbacks(mInputManager);
 
+	// textures created from here on decode in the background and bind a placeholder until uploaded
+	mTextureStreamer = TextureStreamer::Instance();
+	mTextureCache = TextureCache::Instance(); // kept for the lifetime of the app so bodies share their textures
+	mResidency = ResidencyManager::Instance(); // streamed textures register with it, so it comes first
+
+	if (IndirectCommands::IsSupported())
+	{
+		mMeshPool = std::make_unique<MeshPool>(); // filled by the Prepare functions, uploaded after the shape models
+		mIndirectCommands = std::make_unique<IndirectCommands>();
+	}
+
 	PrepareUnitSphereGeometry(); // create a unit sphere geometry for the planets/moons
-	PrepareBackgroundSphereGeometry(); // create a background sphere geometry for the stars
 	PrepareSaturnRingGeometry(); // create ring geometry for saturn
 
-	mBasicShader = std::make_unique<ShaderProgram>(
+	mBasicShaders = std::make_unique<ShaderVariants>(
 		mPath->Get("shaders/test.vert"),
-		mPath->Get("shaders/test.frag")
+		mPath->Get("shaders/test.frag"),
+		std::vector<std::string>{ "UNLIT", "ALPHA_TEST", "NIGHT_MAP", "RING" }, // in ShaderFeature order
+		RingFeature, // samples another texture, a body variant cannot stand in for it
+		[](ShaderProgram& program)->void
+		{
+			glUniformBlockBinding(program, program.uniformBlockIndex(Uniforms::Draws), DrawBlock::Binding);
+			program.setUniform(Uniforms::BodyTextures, BodyTextureUnit);
+			program.setUniform(Uniforms::NightMap, NightMapUnit);
+			program.setUniform(Uniforms::PageCache, PageCacheUnit);
+			program.setUniform(Uniforms::PageTable, PageTableUnit);
+		}
+	);
+	// vertex arrays without the draw id attribute read this value, which makes the shader use baseDraw
+	glVertexAttribI4i(DrawBlock::DrawIdLocation, -1, 0, 0, 0);
+	mDrawRing = std::make_unique<UniformRing>(sizeof(DrawData) * DrawBlock::MaxDraws, DrawBlock::Blocks);
+
+	mSkyboxShader = std::make_unique<ShaderProgram>(
+		mPath->Get("shaders/skybox.vert"),
+		mPath->Get("shaders/skybox.frag")
 	);
+	mSkyboxShader->use();
+	mSkyboxShader->setUniform(Uniforms::Skybox, SkyboxUnit);
+	mSkyboxVertexArray = std::make_unique<VertexArray>();
 
 	// create planets
 	// all planets parameters are scaled relative to 365 seconds = one earth year, or 1 second = 1 day
-	background = std::make_unique<Planet>("textures/8k_stars_milky_way.jpg", 0.0f, 85.0f, 0.0f, 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	mSkybox = std::make_unique<Skybox>(mPath->Get("textures/8k_stars_milky_way.jpg")); // converted into a cubemap on the workers
 
 	planets.emplace_back("textures/2k_sun.jpg", 0.0f, 1.5f, 0.0f, 13.5f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f)); // sun
 	planets.emplace_back("textures/2k_mercury.jpg", 2.5f, 0.2f, 4.15f, 2.07f, 0.0f, 7.0f, planets[0].getPosition()); // mercury
@@ -96,8 +154,16 @@ SolarSystem::SolarSystem()
 	planets.emplace_back("textures/2k_moon.jpg", 2.8f, 0.01f, 330.0f, 330.0f, 0.0f, 0.0f, planets[9].getPosition()); // proteus
 	planets.emplace_back("textures/2k_moon.jpg", 30.0f, 0.01f, 1.01f, 1.01f, 0.0f, 7.0f, planets[9].getPosition()); // nereid
 
-	mSaturnRingTexture = std::make_unique<Texture>(mPath->Get("textures/2k_saturn_ring_alpha.png"), GL_NEAREST);
+	PrepareShapeModels(); // replace the unit sphere for moons that have a shape model
+	if (mMeshPool != nullptr)
+	{
+		mMeshPool->Upload(DrawBlock::DrawIdLocation, DrawBlock::MaxDraws);
+	}
+
+	mSaturnRingTexture = mTextureCache->Load(mPath->Get("textures/2k_saturn_ring_alpha.png"), GL_LINEAR);
+	mEarthNightTexture = mTextureCache->Load(mPath->Get("textures/2k_earth_nightmap.jpg"), GL_LINEAR);
 	mClouds = std::make_unique<Planet>("textures/2k_earth_clouds.jpg", 0.0f, 0.501f, 1.0f, 150.0f, 0.0f, 0.0f, planets[3].getPosition()); // earth
+	PrepareBodyTextures(); // pack the planet, moon and cloud textures into texture arrays
 
 	mTurnTableCamera = std::make_unique<TurnTableCamera>(planets[0].getModel());
 
@@ -132,6 +198,18 @@ void SolarSystem::Run()
 		prevTime = currTime;
 		Update(dt);
 
+		mSkybox->Update();
+		mBasicShaders->Update(); // variants the driver finished draw from this frame on
+		mTextureStreamer->Update(); // upload the next part of the decoded textures
+		if (mPageCache != nullptr)
+		{
+			// pages seen a few frames ago, the readback is never waited for
+			if (mFeedback->Read(mFeedbackTexels))
+			{
+				mPageCache->Request(mFeedbackTexels);
+			}
+			mPageCache->Update();
+		}
 
 		// glEnable(GL_FRAMEBUFFER_SRGB); // Expect Colour to be encoded in sRGB standard (as opposed to RGB)
 		//glClearColor(0.2f, 0.6f, 0.8f, 1.0f);
@@ -141,6 +219,7 @@ void SolarSystem::Run()
 		glViewport(0, 0, mWindow->getWidth(), mWindow->getHeight());
 
 		Render();
+		mResidency->Update(); // resolution of the textures for the coming frames
 
 		// glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui (if used)
 
@@ -153,6 +232,7 @@ void SolarSystem::Run()
 
 		ImGui::Render(); // Render the ImGui window
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Some middleware thing
+		GLState::EndFrame();
 
 
 		mWindow->swapBuffers(); // Swap the buffers while displaying the previous
@@ -264,86 +344,474 @@ void SolarSystem::ResetDefaults()
 
 void SolarSystem::Render()
 {
-	mBasicShader->use();
-
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_BLEND); // enable blending for transparent textures
-	glFrontFace(GL_CCW);
-	glCullFace(GL_BACK);
+	GLState::Enable(GL_CULL_FACE);
+	GLState::FrontFace(GL_CCW);
+	GLState::CullFace(GL_BACK);
 
 	float const aspectRatio = static_cast<float>(mWindow->getWidth()) / static_cast<float>(mWindow->getHeight());
 	auto const projection = glm::perspective(mFovY, aspectRatio, mZNear, mZFar);
-	glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "projection"), 1, GL_FALSE, reinterpret_cast<float const*>(&projection));
-
 	auto const view = mTurnTableCamera->ViewMatrix();
-	glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "view"), 1, GL_FALSE, reinterpret_cast<float const*>(&view));
-
-	// render background
-	background->getTexture()->bind();
-	auto const bgModel = background->getModel();
-	glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, reinterpret_cast<float const*>(&bgModel));
-	mBackgroundSphereGeometry->bind();
-	glDrawArrays(GL_TRIANGLES, 0, mBackgroundSphereIndexCount);
-
-	// render sun 
-	planets[0].getTexture()->bind();
-	auto const sunModel = planets[0].getModel();
-	glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, reinterpret_cast<float const*>(&sunModel));
-	glUniform1i(glGetUniformLocation(*mBasicShader, "noShade"), 1); // disable shading for the sun
-	mUnitSphereGeometry->bind();
-	glDrawArrays(GL_TRIANGLES, 0, mUnitSphereIndexCount);
-
-	// render planets
-	for (size_t i = 1; i < planets.size(); i++)
-	{
-		planets[i].getTexture()->bind();
-		auto const model = planets[i].getModel();
-		glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, reinterpret_cast<float const*>(&model));
-		glUniform1i(glGetUniformLocation(*mBasicShader, "noShade"), 0);
-		mUnitSphereGeometry->bind();
-		glDrawArrays(GL_TRIANGLES, 0, mUnitSphereIndexCount);
+	auto const viewProjection = projection * view;
+
+	mFrameVariants = 0; // the uniforms of the frame are set as the variants are used
+
+	mFrustum = Meshlets::Frustum::FromMatrix(viewProjection);
+	mCameraPosition = mTurnTableCamera->Position();
+	mClusterTrianglesDrawn = 0;
+	mClusterTrianglesTotal = 0;
+	mDrawCalls = 0;
+
+	// collect the draws of this frame, their sort keys decide the order and which of them share a draw call
+	mDrawItems.clear();
+	mRenderQueue.Clear();
+
+	for (size_t i = 0; i < planets.size(); i++)
+	{
+		DrawItem item = BodyItem(i);
+		item.features = i == 0 ? UnlitFeature : i == 3 ? NightMapFeature : 0u; // the sun shines, the earth has city lights
+
+		// shape models are normalized to a unit radius like the sphere
+		glm::vec3 const center = item.model[3];
+		if (mFrustum.Intersects(center, glm::length(glm::vec3(item.model[0]))))
+		{
+			QueueDraw(item, glm::distance(center, mCameraPosition));
+		}
 	}
 
 	if (enableClouds)
 	{
-		// render earths clouds
-		mClouds->getTexture()->bind();
-		auto cloudModel = mClouds->getModel();
-		glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, reinterpret_cast<float const*>(&cloudModel));
-		glUniform1i(glGetUniformLocation(*mBasicShader, "noShade"), 1); // disable shading for the clouds
-		mUnitSphereGeometry->bind();
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-		glDrawArrays(GL_TRIANGLES, 0, mUnitSphereIndexCount);
-	}
-
-	// render saturn ring
-	mSaturnRingTexture->bind();
-	auto ringModel = planets[7].getModel();
-	ringModel = glm::scale(ringModel, glm::vec3(1.3f, 0.0f, 1.3f));
-	glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, reinterpret_cast<float const*>(&ringModel));
-	glUniform1i(glGetUniformLocation(*mBasicShader, "noShade"), 0);
-	mSaturnRingGeometry->bind();
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDrawArrays(GL_TRIANGLES, 0, mSaturnRingIndexCount);
-
-	// render the bottom side of the ring by flipping it 
-	ringModel = glm::rotate(ringModel, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-	glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, reinterpret_cast<float const*>(&ringModel));
-	mSaturnRingGeometry->bind();
-	glDrawArrays(GL_TRIANGLES, 0, mSaturnRingIndexCount);	
-
-	// render point light
-	glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, reinterpret_cast<float const*>(&mLightModel));
-	glm::vec3 lightColor = glm::vec3(1.0f, 1.0f, 1.0f);
-	glm::vec3 lightPos = glm::vec3(0.0f, 0.0f, 0.0f);
-	glm::vec3 viewPos = mTurnTableCamera->Position();
-	glUniform3fv(glGetUniformLocation(*mBasicShader, "lightColor"), 1, reinterpret_cast<float const*>(&lightColor));
-	glUniform3fv(glGetUniformLocation(*mBasicShader, "lightPos"), 1, reinterpret_cast<float const*>(&lightPos));
-	glUniform3fv(glGetUniformLocation(*mBasicShader, "viewPos"), 1, reinterpret_cast<float const*>(&viewPos));
-	glDrawArrays(GL_POINTS, 0, 1);
-	
-	// Hint: Use glDrawElements for using the index buffer (EBO)
+		// earths clouds
+		DrawItem cloudsItem = BodyItem(3);
+		cloudsItem.pipeline = Pipeline::Additive;
+		cloudsItem.material = static_cast<uint32_t>(mCloudsTextureSlot.array);
+		cloudsItem.model = mClouds->getModel();
+		cloudsItem.features = UnlitFeature | AlphaTestFeature; // disable shading for the clouds
+		cloudsItem.layer = mCloudsTextureSlot.layer;
+		cloudsItem.virtualTexture = -1;
+		glm::vec3 const center = cloudsItem.model[3];
+		if (mFrustum.Intersects(center, glm::length(glm::vec3(cloudsItem.model[0]))))
+		{
+			QueueDraw(cloudsItem, glm::distance(center, mCameraPosition));
+		}
+	}
 
+	// saturn ring, the bottom side is the ring flipped
+	DrawItem ringItem{};
+	ringItem.pipeline = Pipeline::AlphaBlend;
+	ringItem.material = SaturnRingMaterial;
+	ringItem.features = RingFeature | AlphaTestFeature;
+	ringItem.mesh = SaturnRingMesh;
+	ringItem.model = glm::scale(planets[7].getModel(), glm::vec3(1.3f, 0.0f, 1.3f));
+	ringItem.geometry = mSaturnRingGeometry.get();
+	ringItem.indexCount = mSaturnRingIndexCount;
+	ringItem.poolMesh = &mSaturnRingMesh;
+	float const ringDepth = glm::distance(glm::vec3(ringItem.model[3]), mCameraPosition);
+	QueueDraw(ringItem, ringDepth);
+	ringItem.model = glm::rotate(ringItem.model, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	QueueDraw(ringItem, ringDepth);
+
+	// point light, from a vertex array without the draw id attribute so baseDraw applies
+	DrawItem lightItem{};
+	lightItem.material = SaturnRingMaterial;
+	lightItem.features = RingFeature | AlphaTestFeature;
+	lightItem.mesh = PointMesh;
+	lightItem.model = mLightModel;
+	lightItem.geometry = mSaturnRingGeometry.get();
+	QueueDraw(lightItem, glm::distance(glm::vec3(mLightModel[3]), mCameraPosition));
+
+	mRenderQueue.Sort();
+	if (mRenderQueue.Size() > DrawBlock::MaxFrameDraws)
+	{
+		if (mDrawsDropped == false)
+		{
+			Log::warning("{} draws queued, only the first {} are drawn", mRenderQueue.Size(), DrawBlock::MaxFrameDraws);
+			mDrawsDropped = true;
+		}
+		mRenderQueue.Truncate(DrawBlock::MaxFrameDraws);
+	}
+	ReportTextureUse(projection);
+
+	// per-draw data in queue order, draws sharing a call occupy consecutive entries. It is built in cpu memory, the
+	// ring may be write-combined memory that is slow to read back
+	mDrawData.clear();
+	for (size_t position = 0; position < mRenderQueue.Size(); position++)
+	{
+		DrawItem const& item = mDrawItems[mRenderQueue.Item(position)];
+		mDrawData.push_back(DrawBlock::Make(item.model, item.layer, item.virtualTexture));
+	}
+	DrawBlock::ComputeMatrices(viewProjection, mDrawData.data(), mDrawData.size());
+	std::byte* const ring = mDrawRing->BeginFrame();
+	for (size_t first = 0; first < mDrawData.size(); first += DrawBlock::MaxDraws)
+	{
+		size_t const count = std::min<size_t>(mDrawData.size() - first, DrawBlock::MaxDraws);
+		std::memcpy(ring + first / DrawBlock::MaxDraws * mDrawRing->BlockSize(), mDrawData.data() + first, count * sizeof(DrawData));
+	}
+	mDrawRing->Flush();
+	mDrawRing->Bind(DrawBlock::Binding);
+	mBoundDrawBlock = 0;
+
+	// opaque batches sort first, the sky goes between them and the blended ones
+	mEarthNightTexture->bind(NightMapUnit);
+	BuildBatches();
+	bool skyDrawn = false;
+	for (DrawBatch const& batch : mDrawBatches)
+	{
+		if (skyDrawn == false && mDrawItems[mRenderQueue.Item(batch.first)].pipeline != Pipeline::Opaque)
+		{
+			RenderSkybox(view, projection);
+			skyDrawn = true;
+		}
+		SubmitBatch(batch);
+	}
+	if (skyDrawn == false)
+	{
+		RenderSkybox(view, projection);
+	}
+
+	if (mPageCache != nullptr)
+	{
+		RenderFeedback();
+	}
+
+	mDrawRing->EndFrame();
+}
+
+//======================================================================================================================
+
+SolarSystem::DrawItem SolarSystem::BodyItem(size_t const index)
+{
+	DrawItem item{};
+	item.material = static_cast<uint32_t>(mBodyTextureSlots[index].array);
+	item.model = planets[index].getModel();
+	item.layer = mBodyTextureSlots[index].layer;
+	item.virtualTexture = mBodyVirtualTextures[index];
+	if (item.virtualTexture >= 0)
+	{
+		item.material = FirstVirtualMaterial + static_cast<uint32_t>(item.virtualTexture);
+	}
+
+	auto const shapeModel = mShapeModels.find(index);
+	if (shapeModel != mShapeModels.end())
+	{
+		item.mesh = FirstShapeModelMesh + static_cast<uint32_t>(index);
+		item.geometry = shapeModel->second.geometry.get();
+		item.indexCount = shapeModel->second.indexCount;
+		item.meshlets = &shapeModel->second.meshlets;
+		item.poolMesh = &shapeModel->second.mesh;
+		return item;
+	}
+
+	item.mesh = UnitSphereMesh;
+	item.geometry = mUnitSphereGeometry.get();
+	item.indexCount = mUnitSphereIndexCount;
+	item.meshlets = &mUnitSphereMeshlets;
+	item.poolMesh = &mUnitSphereMesh;
+	return item;
+}
+
+//======================================================================================================================
+
+void SolarSystem::QueueDraw(DrawItem const& item, float const depth)
+{
+	// the shader variant is part of the state a batch shares
+	uint32_t const pipeline = static_cast<uint32_t>(item.pipeline) | item.features << 2;
+	uint64_t const key = item.pipeline == Pipeline::Opaque
+		? SortKey::Opaque(pipeline, item.material, item.mesh, depth)
+		: SortKey::Transparent(depth, pipeline, item.material, item.mesh);
+	mRenderQueue.Push(key, static_cast<uint32_t>(mDrawItems.size()));
+	mDrawItems.push_back(item);
+	mClusterTrianglesTotal += static_cast<size_t>(item.indexCount) / 3;
+}
+
+//======================================================================================================================
+
+void SolarSystem::BuildBatches()
+{
+	// consecutive items join a batch when only their per-draw data differs. Indirect batches may mix meshes of the
+	// pool, their commands are built and uploaded here so every batch is drawn from one upload
+	bool const indirect = mMeshPool != nullptr && useIndirectDraws;
+	mDrawBatches.clear();
+	if (indirect)
+	{
+		mIndirectCommands->Clear();
+	}
+
+	for (size_t position = 0; position < mRenderQueue.Size(); position++)
+	{
+		DrawItem const& item = mDrawItems[mRenderQueue.Item(position)];
+		bool const pooled = indirect && item.poolMesh != nullptr;
+
+		bool joins = false;
+		if (mDrawBatches.empty() == false)
+		{
+			DrawBatch const& batch = mDrawBatches.back();
+			DrawItem const& first = mDrawItems[mRenderQueue.Item(batch.first)];
+			// a batch reaches its entries through one bound block, so it ends with the block
+			joins = first.pipeline == item.pipeline && first.features == item.features && first.material == item.material
+				&& batch.indirect == pooled && (pooled || first.mesh == item.mesh)
+				&& batch.first / DrawBlock::MaxDraws == position / DrawBlock::MaxDraws;
+		}
+		if (joins == false)
+		{
+			mDrawBatches.push_back({ position, 0, pooled, pooled ? mIndirectCommands->Size() : 0, 0 });
+		}
+		DrawBatch& batch = mDrawBatches.back();
+		batch.count++;
+
+		if (pooled)
+		{
+			GLuint const drawEntry = static_cast<GLuint>(position % DrawBlock::MaxDraws);
+			if (item.meshlets != nullptr)
+			{
+				CullClusters(*item.meshlets, item.model);
+				mIndirectCommands->Add(*item.poolMesh, mClusterRanges, drawEntry);
+			}
+			else
+			{
+				mIndirectCommands->Add(*item.poolMesh, drawEntry);
+				mClusterTrianglesDrawn += static_cast<size_t>(item.indexCount) / 3;
+			}
+			batch.commandCount = mIndirectCommands->Size() - batch.firstCommand;
+		}
+	}
+
+	if (indirect)
+	{
+		mIndirectCommands->Upload();
+	}
+}
+
+//======================================================================================================================
+
+void SolarSystem::SubmitBatch(DrawBatch const& batch)
+{
+	DrawItem const& first = mDrawItems[mRenderQueue.Item(batch.first)];
+	ShaderProgram* const variant = UseBasicShader(first.features);
+	if (variant == nullptr)
+	{
+		return; // its variant failed to build and nothing can stand in for it
+	}
+	ShaderProgram& program = *variant;
+	ApplyPipeline(first.pipeline);
+	BindMaterial(first.material, program);
+	GLint const baseDraw = BindDrawBlock(batch.first);
+	mDrawCalls++;
+
+	if (batch.indirect)
+	{
+		mMeshPool->Bind();
+		mIndirectCommands->Draw(batch.firstCommand, batch.commandCount);
+		return;
+	}
+
+	first.geometry->bind();
+	program.setUniform(Uniforms::BaseDraw, baseDraw);
+	GLsizei const instanceCount = static_cast<GLsizei>(batch.count);
+	if (first.indexCount == 0)
+	{
+		glDrawArraysInstanced(GL_POINTS, 0, 1, instanceCount);
+	}
+	else if (batch.count == 1 && first.meshlets != nullptr)
+	{
+		DrawClusters(*first.meshlets, first.model);
+	}
+	else
+	{
+		// several bodies of the same mesh, the shader reaches their entries through gl_InstanceID
+		glDrawElementsInstanced(GL_TRIANGLES, first.indexCount, GL_UNSIGNED_INT, nullptr, instanceCount);
+		mClusterTrianglesDrawn += static_cast<size_t>(first.indexCount) / 3 * batch.count;
+	}
+}
+
+//======================================================================================================================
+
+GLint SolarSystem::BindDrawBlock(size_t const position)
+{
+	size_t const block = position / DrawBlock::MaxDraws;
+	if (block != mBoundDrawBlock)
+	{
+		mDrawRing->Bind(DrawBlock::Binding, block);
+		mBoundDrawBlock = block;
+	}
+	return static_cast<GLint>(position % DrawBlock::MaxDraws);
+}
+
+//======================================================================================================================
+
+void SolarSystem::ApplyPipeline(Pipeline const pipeline)
+{
+	switch (pipeline)
+	{
+	case Pipeline::Opaque:
+		GLState::Disable(GL_BLEND);
+		break;
+	case Pipeline::Additive:
+		GLState::Enable(GL_BLEND);
+		GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE);
+		break;
+	case Pipeline::AlphaBlend:
+		GLState::Enable(GL_BLEND); // enable blending for transparent textures
+		GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		break;
+	}
+}
+
+//======================================================================================================================
+
+ShaderProgram* SolarSystem::UseBasicShader(uint32_t const features)
+{
+	// until its variant is built the draw uses a fallback, which gets the uniforms of the frame on its own
+	std::optional<uint32_t> const resolved = mBasicShaders->Resolve(features);
+	if (resolved.has_value() == false)
+	{
+		return nullptr;
+	}
+	uint32_t const variant = *resolved;
+	ShaderProgram& program = mBasicShaders->Get(variant);
+	program.use();
+	if ((mFrameVariants >> variant & 1u) == 0)
+	{
+		// point light at the sun
+		program.setUniform(Uniforms::LightColor, glm::vec3(1.0f, 1.0f, 1.0f));
+		program.setUniform(Uniforms::LightPos, glm::vec3(0.0f, 0.0f, 0.0f));
+		program.setUniform(Uniforms::ViewPos, mCameraPosition);
+		mFrameVariants |= 1u << variant;
+	}
+	return &program;
+}
+
+//======================================================================================================================
+
+void SolarSystem::BindMaterial(uint32_t const material, ShaderProgram const& program)
+{
+	if (material == SaturnRingMaterial)
+	{
+		mSaturnRingTexture->bind();
+	}
+	else if (material >= FirstVirtualMaterial)
+	{
+		int const virtualTexture = static_cast<int>(material - FirstVirtualMaterial);
+		mPageCache->Bind(virtualTexture, PageCacheUnit, PageTableUnit);
+		program.setUniform(Uniforms::VirtualSize, mPageCache->Parameters(virtualTexture));
+	}
+	else
+	{
+		BindBodyTextures(material);
+	}
+}
+
+//======================================================================================================================
+
+void SolarSystem::RenderFeedback()
+{
+	// every opaque body is drawn so the ones in front hide the pages behind them
+	mFeedback->Begin(mWindow->getWidth(), mWindow->getHeight());
+	mFeedbackShader->use();
+	ApplyPipeline(Pipeline::Opaque);
+	mFeedbackShader->setUniform(Uniforms::LodBias, -std::log2(static_cast<float>(FeedbackBuffer::Scale)));
+	for (size_t position = 0; position < mRenderQueue.Size(); position++)
+	{
+		DrawItem const& item = mDrawItems[mRenderQueue.Item(position)];
+		if (item.pipeline != Pipeline::Opaque || item.indexCount == 0)
+		{
+			continue;
+		}
+		if (item.virtualTexture >= 0)
+		{
+			mFeedbackShader->setUniform(Uniforms::VirtualSize, mPageCache->Parameters(item.virtualTexture));
+		}
+		item.geometry->bind();
+		mFeedbackShader->setUniform(Uniforms::BaseDraw, BindDrawBlock(position));
+		glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, nullptr);
+	}
+	mFeedback->End();
+}
+
+//======================================================================================================================
+
+void SolarSystem::RenderSkybox(glm::mat4 const& view, glm::mat4 const& projection)
+{
+	if (mSkybox->IsResident() == false)
+	{
+		return; // the clear color shows until every face is uploaded
+	}
+
+	mSkyboxShader->use();
+	mSkyboxShader->setUniform(Uniforms::InverseViewProjection, glm::inverse(projection * glm::mat4(glm::mat3(view))));
+	ApplyPipeline(Pipeline::Opaque);
+	GLState::DepthFunc(GL_LEQUAL); // the triangle lies on the cleared depth
+	GLState::DepthMask(false);
+	mSkybox->Bind(SkyboxUnit);
+	mSkyboxVertexArray->bind();
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	mDrawCalls++;
+
+	GLState::DepthMask(true);
+	GLState::DepthFunc(GL_LESS);
+}
+
+//======================================================================================================================
+
+void SolarSystem::ReportTextureUse(glm::mat4 const& projection)
+{
+	// pixels covered by one unit at a distance of one
+	float const pixelsPerUnit = projection[1][1] * 0.5f * static_cast<float>(mWindow->getHeight());
+	for (DrawItem const& item : mDrawItems)
+	{
+		if (item.mesh == PointMesh || item.virtualTexture >= 0)
+		{
+			continue;
+		}
+
+		glm::vec3 const center = item.model[3];
+		float const radius = glm::length(glm::vec3(item.model[0]));
+		float const distance = std::max(glm::distance(center, mCameraPosition), mZNear);
+		if (item.material == SaturnRingMaterial)
+		{
+			mResidency->Use(mSaturnRingTexture->getStreamed().get(), radius * pixelsPerUnit / distance);
+		}
+		else
+		{
+			// wrapped around the body, at the center of its disc the texture width spans pi diameters
+			float const screenSize = glm::two_pi<float>() * radius * pixelsPerUnit / distance;
+			mResidency->Use(mBodyTextures[item.material]->Streamed().get(), screenSize);
+			if ((item.features & NightMapFeature) != 0)
+			{
+				mResidency->Use(mEarthNightTexture->getStreamed().get(), screenSize);
+			}
+		}
+	}
+}
+
+//======================================================================================================================
+
+void SolarSystem::BindBodyTextures(size_t const array) const
+{
+	mBodyTextures[array]->Bind(BodyTextureUnit);
+}
+
+//======================================================================================================================
+
+void SolarSystem::CullClusters(std::vector<Meshlet> const& meshlets, glm::mat4 const& model)
+{
+	mClusterRanges.Clear();
+	Meshlets::Cull(meshlets, model, mFrustum, mCameraPosition, mClusterRanges);
+
+	for (GLsizei const count : mClusterRanges.counts)
+	{
+		mClusterTrianglesDrawn += static_cast<size_t>(count) / 3;
+	}
+}
+
+//======================================================================================================================
+
+void SolarSystem::DrawClusters(std::vector<Meshlet> const& meshlets, glm::mat4 const& model)
+{
+	CullClusters(meshlets, model);
+	if (mClusterRanges.counts.empty() == false)
+	{
+		glMultiDrawElements(GL_TRIANGLES, mClusterRanges.counts.data(), GL_UNSIGNED_INT, mClusterRanges.offsets.data(), static_cast<GLsizei>(mClusterRanges.counts.size()));
+	}
 }
 
 //======================================================================================================================
@@ -368,6 +836,88 @@ void SolarSystem::UI()
 
 	// enable/disable clouds
 	ImGui::Checkbox("Show clouds", &enableClouds);
+
+	ImGui::Text("Triangles drawn: %zu / %zu", mClusterTrianglesDrawn, mClusterTrianglesTotal);
+	ImGui::Text("Draw calls: %zu for %zu draws", mDrawCalls, mRenderQueue.Size());
+	ImGui::Text("Shader variants: %zu", mBasicShaders->Count());
+	if (mBasicShaders->PendingCount() > 0)
+	{
+		ImGui::SameLine();
+		ImGui::Text("(%zu building)", mBasicShaders->PendingCount());
+	}
+	if (ImGui::Button("Reload shaders"))
+	{
+		mBasicShaders->Reload();
+	}
+	if (mTextureStreamer->PendingCount() > 0)
+	{
+		ImGui::Text("Textures streaming: %zu", mTextureStreamer->PendingCount());
+	}
+	if (ImGui::SliderInt("Texture budget (MiB)", &mTextureBudgetMiB, 16, 1024))
+	{
+		mResidency->SetBudget(static_cast<size_t>(mTextureBudgetMiB) * 1024 * 1024);
+	}
+	ImGui::Text("Streamed textures: %.1f MiB in %zu textures", static_cast<double>(mResidency->ByteSize()) / (1024.0 * 1024.0), mResidency->TextureCount());
+	if (mPageCache != nullptr && mPageCache->PendingCount() > 0)
+	{
+		ImGui::Text("Virtual texture pages loading: %zu", mPageCache->PendingCount());
+	}
+	if (mMeshPool != nullptr)
+	{
+		ImGui::Checkbox("Multi-draw indirect", &useIndirectDraws);
+	}
+	if (mMeshPool != nullptr && useIndirectDraws)
+	{
+		ImGui::Text("Indirect commands: %zu", mIndirectCommands->Size());
+	}
+
+	// redundant state changes the state cache kept from the driver in the last frame
+	GLState::Counters const& stateCalls = GLState::LastFrame();
+	uint32_t issued = 0;
+	uint32_t avoided = 0;
+	for (size_t i = 0; i < stateCalls.issued.size(); ++i)
+	{
+		issued += stateCalls.issued[i];
+		avoided += stateCalls.avoided[i];
+	}
+	if (ImGui::TreeNode("GL state calls", "GL state calls avoided: %u / %u", avoided, issued + avoided))
+	{
+		for (size_t i = 0; i < stateCalls.issued.size(); ++i)
+		{
+			ImGui::Text("%s: %u / %u", GLState::CallNames[i], stateCalls.avoided[i], stateCalls.issued[i] + stateCalls.avoided[i]);
+		}
+		ImGui::TreePop();
+	}
+
+	// textures shared through the cache, the body texture arrays are listed with them
+	size_t textureBytes = mTextureCache->ByteSize() + mSkybox->ByteSize() + (mPageCache != nullptr ? mPageCache->ByteSize() : 0);
+	for (std::unique_ptr<TextureArray> const& array : mBodyTextures)
+	{
+		textureBytes += array->ByteSize();
+	}
+	if (ImGui::TreeNode("Texture memory", "Texture memory: %.1f MiB", static_cast<double>(textureBytes) / (1024.0 * 1024.0)))
+	{
+		ImGui::Text("Skybox, 6 faces of %dx%d%s: %.1f MiB", mSkybox->FaceSize(), mSkybox->FaceSize(),
+			mSkybox->IsResident() ? "" : ", streaming", static_cast<double>(mSkybox->ByteSize()) / (1024.0 * 1024.0));
+		if (mPageCache != nullptr)
+		{
+			ImGui::Text("Page cache, %zu / %zu pages: %.1f MiB", mPageCache->ResidentCount(), mPageCache->SlotCount(),
+				static_cast<double>(mPageCache->ByteSize()) / (1024.0 * 1024.0));
+		}
+		for (size_t i = 0; i < mBodyTextures.size(); ++i)
+		{
+			TextureArray const& array = *mBodyTextures[i];
+			ImGui::Text("Body array %zu, %d layers of %dx%d: %.1f MiB", i, array.LayerCount(), array.Dimensions().x,
+				array.Dimensions().y, static_cast<double>(array.ByteSize()) / (1024.0 * 1024.0));
+		}
+		for (TextureCache::Entry const& entry : mTextureCache->Report())
+		{
+			std::string const name = std::filesystem::path(entry.path).filename().string();
+			ImGui::Text("%s, %ld users%s: %.1f MiB", name.c_str(), entry.users, entry.resident ? "" : ", streaming",
+				static_cast<double>(entry.bytes) / (1024.0 * 1024.0));
+		}
+		ImGui::TreePop();
+	}
 	ImGui::End();
 
 }
@@ -376,29 +926,136 @@ void SolarSystem::UI()
 
 void SolarSystem::PrepareUnitSphereGeometry()
 {
+	// generated and clustered on the first run, later runs map it from the geometry cache. The triangles are in
+	// cluster order so visible clusters can be drawn as index ranges
 	mUnitSphereGeometry = std::make_unique<GPU_Geometry>();
+	GeometryCache::Entry sphere = GeometryCache::Load(
+		{ "sphere", { 1.0f, 100.0f, 100.0f } },
+		[]()->CPU_Geometry { return ShapeGenerator::Sphere(1.0f, 100, 100); },
+		true
+	);
+	mUnitSphereMeshlets = std::move(sphere.meshlets);
 
-	auto const unitSphere = ShapeGenerator::Sphere(1.0f, 100, 100);
-
-	mUnitSphereGeometry->Update(unitSphere);
+	mUnitSphereGeometry->Update(sphere.view);
+	if (mMeshPool != nullptr)
+	{
+		mUnitSphereMesh = mMeshPool->Add(sphere.view);
+	}
+	mUnitSphereIndexCount = sphere.ElementCount();
+}
 
-	mUnitSphereIndexCount = static_cast<int>(unitSphere.positions.size());
+void SolarSystem::PrepareSaturnRingGeometry()
+{
+	GeometryCache::Entry const ring = GeometryCache::Load(
+		{ "ring", { 1.0f, 0.5f, 200.0f } },
+		[]()->CPU_Geometry { return ShapeGenerator::Ring(1.0f, 0.5f, 200); }
+	);
+	mSaturnRingGeometry = std::make_unique<GPU_Geometry>();
+	mSaturnRingGeometry->Update(ring.view);
+	mSaturnRingIndexCount = ring.ElementCount();
+	if (mMeshPool != nullptr)
+	{
+		mSaturnRingMesh = mMeshPool->Add(ring.view);
+	}
 }
 
-void SolarSystem::PrepareBackgroundSphereGeometry()
+void SolarSystem::PrepareBodyTextures()
 {
-	mBackgroundSphereGeometry = std::make_unique<GPU_Geometry>();
-	auto const backgroundSphere = ShapeGenerator::BackgroundSphere(1.0f, 100, 100);
-	mBackgroundSphereGeometry->Update(backgroundSphere);
-	mBackgroundSphereIndexCount = static_cast<int>(backgroundSphere.positions.size());
+	// bodies with a page file sample their virtual texture and need no layer, the moons share one like a layer
+	std::unordered_map<std::string, int> virtualTextures{};
+	mBodyVirtualTextures.assign(planets.size(), -1);
+	for (size_t i = 0; i < planets.size(); ++i)
+	{
+		std::string const& path = planets[i].getTexturePath();
+		auto const found = virtualTextures.find(path);
+		if (found != virtualTextures.end())
+		{
+			mBodyVirtualTextures[i] = found->second;
+			continue;
+		}
+		std::unique_ptr<PageFile> pages = PageFile::Load(PageFile::PathFor(path));
+		if (pages == nullptr)
+		{
+			continue;
+		}
+		if (mPageCache == nullptr)
+		{
+			mPageCache = std::make_unique<PageCache>();
+			mFeedback = std::make_unique<FeedbackBuffer>();
+			mFeedbackShader = std::make_unique<ShaderProgram>(mPath->Get("shaders/test.vert"), mPath->Get("shaders/feedback.frag"));
+			glUniformBlockBinding(*mFeedbackShader, mFeedbackShader->uniformBlockIndex(Uniforms::Draws), DrawBlock::Binding);
+		}
+		mBodyVirtualTextures[i] = mPageCache->Add(std::move(pages));
+		virtualTextures.emplace(path, mBodyVirtualTextures[i]);
+	}
+
+	TextureArrayBuilder builder{};
+	mBodyTextureSlots.clear();
+	mBodyTextureSlots.reserve(planets.size());
+	for (size_t i = 0; i < planets.size(); ++i)
+	{
+		// moons sharing a texture share the layer
+		mBodyTextureSlots.push_back(mBodyVirtualTextures[i] < 0 ? builder.Add(planets[i].getTexturePath()) : TextureArrayBuilder::Slot{ 0, -1 });
+	}
+	mCloudsTextureSlot = builder.Add(mClouds->getTexturePath());
+	mBodyTextures = builder.Build(GL_LINEAR);
 }
 
-void SolarSystem::PrepareSaturnRingGeometry()
+//======================================================================================================================
+
+void SolarSystem::PrepareShapeModels()
 {
-	mSaturnRingGeometry = std::make_unique<GPU_Geometry>();
-	auto const saturnRing = ShapeGenerator::Ring(1.0f, 0.5f, 200);
-	mSaturnRingGeometry->Update(saturnRing);
-	mSaturnRingIndexCount = static_cast<int>(saturnRing.positions.size());
+	// body index in planets and the file name without extension
+	static constexpr std::pair<size_t, char const*> shapeModels[]
+	{
+		{ 10, "models/phobos" },
+		{ 11, "models/deimos" },
+		{ 22, "models/proteus" },
+	};
+
+	for (auto const& [planetIndex, name] : shapeModels)
+	{
+		for (char const* extension : { ".glb", ".obj" })
+		{
+			std::string const path = mPath->Get(std::string(name) + extension);
+			if (std::filesystem::exists(path) == false)
+			{
+				continue;
+			}
+
+			try
+			{
+				// keyed by the model file contents, so the model is only parsed and clustered again after it changes
+				GeometryCache::Entry model = GeometryCache::Load(
+					{ std::string("shape_") + std::filesystem::path(name).filename().string(), {}, DiskCache::HashFile(path) },
+					[&path]()->CPU_Geometry
+					{
+						CPU_Geometry geometry = MeshLoader::Load(path);
+						MeshLoader::NormalizeToUnitRadius(geometry);
+						return geometry;
+					},
+					true
+				);
+
+				ShapeModel shapeModel{};
+				shapeModel.meshlets = std::move(model.meshlets);
+				shapeModel.geometry = std::make_unique<GPU_Geometry>();
+				shapeModel.geometry->Update(model.view);
+				shapeModel.indexCount = model.ElementCount();
+				if (mMeshPool != nullptr)
+				{
+					shapeModel.mesh = mMeshPool->Add(model.view);
+				}
+				mShapeModels[planetIndex] = std::move(shapeModel);
+				Log::info("Loaded shape model {} ({} triangles)", path, model.view.indexCount / 3);
+			}
+			catch (std::runtime_error const& e)
+			{
+				Log::warning("Failed to load shape model {}: {}", path, e.what());
+			}
+			break;
+		}
+	}
 }
 
 //======================================================================================================================
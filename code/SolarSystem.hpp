@@ -1,13 +1,28 @@
 #pragma once
 
 #include "AssetPath.h"
+#include "DrawData.hpp"
+#include "FeedbackBuffer.hpp"
 #include "Geometry.h"
 #include "InputManager.hpp"
+#include "MeshPool.hpp"
+#include "PageCache.hpp"
+#include "ResidencyManager.hpp"
 #include "ShaderProgram.h"
+#include "ShaderVariants.hpp"
+#include "Skybox.hpp"
 #include "Texture.h"
+#include "TextureArray.hpp"
+#include "TextureCache.hpp"
+#include "TextureStreamer.hpp"
 #include "Time.hpp"
 #include "TurnTableCamera.hpp"
+#include "UniformRing.hpp"
 #include "Planet.h"
+#include "RenderQueue.hpp"
+#include "Meshlet.hpp"
+
+#include <unordered_map>
 
 class SolarSystem
 {
@@ -33,10 +48,104 @@ private:
 
 	void PrepareUnitSphereGeometry(); // creates a unit sphere geometry for the planets/moons
 
-	void PrepareBackgroundSphereGeometry(); // creates a sphere with opposite triangle winding 
-
 	void PrepareSaturnRingGeometry(); // creates ring geometry for saturn
 
+	void PrepareShapeModels(); // loads the meshes of irregular bodies that have one in assets/models
+
+	void PrepareBodyTextures(); // packs the textures of the planets/moons and clouds into texture arrays
+
+	void BindBodyTextures(size_t array) const; // binds a body texture array to BodyTextureUnit
+
+	// fixed-function state of a draw with the basic shader, the pipeline field of the sort key
+	enum class Pipeline : uint32_t
+	{
+		Opaque,
+		Additive,   // clouds
+		AlphaBlend, // saturn ring
+	};
+
+	// feature defines of the basic shader, each combination drawn with is compiled into a variant of it
+	enum ShaderFeature : uint32_t
+	{
+		UnlitFeature = 1u << 0,     // UNLIT
+		AlphaTestFeature = 1u << 1, // ALPHA_TEST
+		NightMapFeature = 1u << 2,  // NIGHT_MAP
+		RingFeature = 1u << 3,      // RING
+	};
+
+	// materials are the body texture arrays followed by these
+	inline static constexpr uint32_t FirstVirtualMaterial = SortKey::MaxMaterials - 1 - PageCache::MaxTextures; // + id
+	inline static constexpr uint32_t SaturnRingMaterial = SortKey::MaxMaterials - 1;
+
+	enum MeshId : uint32_t
+	{
+		UnitSphereMesh,
+		SaturnRingMesh,
+		PointMesh,
+		FirstShapeModelMesh, // + index in planets
+	};
+
+	// one draw of the frame, ordered by the render queue
+	struct DrawItem
+	{
+		Pipeline pipeline = Pipeline::Opaque;
+		uint32_t material = 0;
+		uint32_t mesh = 0;
+		glm::mat4 model{};
+		uint32_t features = 0; // ShaderFeature mask
+		int layer = -1; // in the body texture array
+		int virtualTexture = -1; // id in mPageCache, sampled instead of the layer
+		GPU_Geometry* geometry = nullptr;
+		GLsizei indexCount = 0; // 0 draws a single point
+		std::vector<Meshlet> const* meshlets = nullptr; // cluster culled when drawn alone
+		MeshPool::Mesh const* poolMesh = nullptr; // the mesh in mMeshPool, null if it isn't in there
+	};
+
+	// consecutive queue positions drawn by one call
+	struct DrawBatch
+	{
+		size_t first = 0;
+		size_t count = 0;
+		bool indirect = false;
+		size_t firstCommand = 0;
+		size_t commandCount = 0;
+	};
+
+	DrawItem BodyItem(size_t index); // draw of a planet/moon with its sphere or shape model
+
+	void QueueDraw(DrawItem const& item, float depth);
+
+	void BuildBatches();
+
+	void SubmitBatch(DrawBatch const& batch);
+
+	// binds the DrawBlock block holding the entry of the draw at position in the queue, returns the entry's index
+	// within that block
+	GLint BindDrawBlock(size_t position);
+
+	void ApplyPipeline(Pipeline pipeline);
+
+	// the variant of the basic shader for the features in use, with the uniforms of this frame set. Null when it
+	// failed to build and no other variant can stand in, the draw is skipped
+	ShaderProgram* UseBasicShader(uint32_t features);
+
+	void BindMaterial(uint32_t material, ShaderProgram const& program);
+
+	// draws the opaque bodies of the queue with the feedback shader to find the visible virtual texture pages
+	void RenderFeedback();
+
+	// fills the pixels the opaque draws left with the sky, at the far plane so early-z rejects the covered ones
+	void RenderSkybox(glm::mat4 const& view, glm::mat4 const& projection);
+
+	// tells the ResidencyManager how large the textures of the queued draws are on screen
+	void ReportTextureUse(glm::mat4 const& projection);
+
+	// fills mClusterRanges with the clusters of a mesh that survive frustum and back-face culling
+	void CullClusters(std::vector<Meshlet> const& meshlets, glm::mat4 const& model);
+
+	// draws the clusters of a mesh that survive frustum and back-face culling, the mesh must be bound
+	void DrawClusters(std::vector<Meshlet> const& meshlets, glm::mat4 const& model);
+
 	void OnResize(int width, int height);
 
 	void OnMouseWheelChange(double xOffset, double yOffset) const;
@@ -45,24 +154,83 @@ private:
 	std::shared_ptr<Time> mTime{};
 	std::unique_ptr<Window> mWindow;
 	std::shared_ptr<InputManager> mInputManager{};
+	std::shared_ptr<TextureStreamer> mTextureStreamer{};
+	std::shared_ptr<TextureCache> mTextureCache{};
+	std::shared_ptr<ResidencyManager> mResidency{};
+	int mTextureBudgetMiB = static_cast<int>(ResidencyManager::DefaultBudget / (1024 * 1024));
+
+	std::unique_ptr<ShaderVariants> mBasicShaders{};
+	uint32_t mFrameVariants = 0; // bit per feature mask whose variant has the uniforms of this frame
 
-	std::unique_ptr<ShaderProgram> mBasicShader{};
+	std::unique_ptr<UniformRing> mDrawRing{}; // per-draw data of the frames in flight
 
 	glm::mat4 mLightModel; // lights model matrix
 
 	std::unique_ptr<GPU_Geometry> mUnitSphereGeometry{};
 	int mUnitSphereIndexCount{};
+	std::vector<Meshlet> mUnitSphereMeshlets{};
 
-	std::unique_ptr<GPU_Geometry> mBackgroundSphereGeometry{};
-	int mBackgroundSphereIndexCount{};
+	// stars drawn by direction from one full-screen triangle, it has no vertex attributes
+	inline static constexpr GLint SkyboxUnit = 4;
+	std::unique_ptr<Skybox> mSkybox{};
+	std::unique_ptr<ShaderProgram> mSkyboxShader{};
+	std::unique_ptr<VertexArray> mSkyboxVertexArray{};
 
-	std::unique_ptr<Planet> background{}; // background planet
 	std::unique_ptr<Planet> mClouds{}; // clouds planet
 
 	std::vector<Planet> planets{}; // list of planets (including moons)
 
+	// textures of planets/moons and clouds, sampled from bodyTextures on its own unit so baseColorTexture stays on 0
+	inline static constexpr GLint BodyTextureUnit = 1;
+	std::vector<std::unique_ptr<TextureArray>> mBodyTextures{};
+	inline static constexpr GLint NightMapUnit = 5;
+	std::shared_ptr<Texture> mEarthNightTexture{}; // lights on the dark side of the earth
+	std::vector<TextureArrayBuilder::Slot> mBodyTextureSlots{}; // per planet
+	TextureArrayBuilder::Slot mCloudsTextureSlot{};
+
+	// bodies with a page file in textures/pages sample a virtual texture instead, only created if there is one
+	inline static constexpr GLint PageCacheUnit = 2;
+	inline static constexpr GLint PageTableUnit = 3;
+	std::unique_ptr<PageCache> mPageCache{};
+	std::vector<int> mBodyVirtualTextures{}; // per planet, -1 without one
+	std::unique_ptr<ShaderProgram> mFeedbackShader{};
+	std::unique_ptr<FeedbackBuffer> mFeedback{};
+	std::vector<uint32_t> mFeedbackTexels{};
+
+	// irregular bodies drawn with their own mesh instead of the unit sphere, keyed by index in planets
+	struct ShapeModel
+	{
+		std::unique_ptr<GPU_Geometry> geometry{};
+		int indexCount{};
+		std::vector<Meshlet> meshlets{};
+		MeshPool::Mesh mesh{}; // the same mesh in mMeshPool
+	};
+	std::unordered_map<size_t, ShapeModel> mShapeModels{};
+
+	// draws of the current frame
+	std::vector<DrawItem> mDrawItems{};
+	std::vector<DrawData> mDrawData{}; // DrawBlock entries in queue order
+	size_t mBoundDrawBlock = 0;
+	bool mDrawsDropped = false; // the queue outgrew DrawBlock::MaxFrameDraws, reported once
+	RenderQueue mRenderQueue{};
+	std::vector<DrawBatch> mDrawBatches{};
+	size_t mDrawCalls = 0;
+
+	// multi-draw-indirect path, only created when the context has GL 4.3 and the modern loader is used
+	std::unique_ptr<MeshPool> mMeshPool{};
+	MeshPool::Mesh mUnitSphereMesh{};
+	MeshPool::Mesh mSaturnRingMesh{};
+	std::unique_ptr<IndirectCommands> mIndirectCommands{};
+
+	// per-frame cluster culling state
+	Meshlets::Frustum mFrustum{};
+	glm::vec3 mCameraPosition{};
+	Meshlets::DrawRanges mClusterRanges{};
+	size_t mClusterTrianglesDrawn = 0;
+	size_t mClusterTrianglesTotal = 0;
+
 	// saturn ring geometry and textures
-	std::unique_ptr<Texture> mSaturnRingTexture{};
+	std::shared_ptr<Texture> mSaturnRingTexture{};
 	std::unique_ptr<GPU_Geometry> mSaturnRingGeometry{};
 	int mSaturnRingIndexCount{};
 
@@ -95,4 +263,5 @@ private:
 	bool reset = false;
 	float timeScale = 1.0f;
 	bool enableClouds = false;
+	bool useIndirectDraws = true;
 };
@@ -0,0 +1,128 @@
+#include "StreamedTexture.hpp"
+
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+//======================================================================================================================
+
+static GLenum ChannelsToFormat(int const channels)
+{
+	switch (channels)
+	{
+	case 4: return GL_RGBA;
+	case 3: return GL_RGB;
+	case 2: return GL_RG;
+	case 1: return GL_RED;
+	default: throw std::runtime_error("Invalid texture format");
+	}
+}
+
+//======================================================================================================================
+
+StreamedTexture::StreamedTexture(
+	GLenum const target,
+	int const width,
+	int const height,
+	int const channels,
+	std::vector<std::string> paths,
+	GLint const interpolation,
+	int const firstLevel
+)
+	: mTarget(target)
+	, mWidth(width)
+	, mHeight(height)
+	, mChannels(channels)
+	, mFormat(ChannelsToFormat(channels))
+	, mLevelCount(Mips::LevelCount(width, height))
+	, mPaths(std::move(paths))
+	, mInterpolation(interpolation)
+{
+	TextureStreamer::CreatePlaceholder(mTarget, mPlaceholder, static_cast<int>(mPaths.size()), mFormat);
+	StreamFrom(firstLevel);
+}
+
+//======================================================================================================================
+
+GLuint StreamedTexture::Texture()
+{
+	Update();
+	return mCurrent != nullptr ? mCurrent->texture : mPlaceholder;
+}
+
+//======================================================================================================================
+
+void StreamedTexture::Update()
+{
+	if (mPending == nullptr)
+	{
+		return;
+	}
+	bool const resident = std::all_of(mPending->layers.begin(), mPending->layers.end(), [](auto const& layer)->bool
+	{
+		return layer->IsResident();
+	});
+	if (resident)
+	{
+		mCurrent = std::move(mPending);
+	}
+}
+
+//======================================================================================================================
+
+void StreamedTexture::StreamFrom(int firstLevel)
+{
+	firstLevel = std::clamp(firstLevel, 0, mLevelCount - 1);
+	if (mCurrent != nullptr && mCurrent->firstLevel == firstLevel)
+	{
+		mPending.reset(); // back to what is resident, cancels the stream
+		return;
+	}
+	if (mPending != nullptr && mPending->firstLevel == firstLevel)
+	{
+		return;
+	}
+
+	// dropping the previous pending storage drops its tickets, which cancels the decodes that did not start
+	mPending = std::make_unique<Storage>();
+	mPending->firstLevel = firstLevel;
+
+	int const layers = static_cast<int>(mPaths.size());
+	TextureStreamer::Target target{ mTarget, mPending->texture, 0, mWidth, mHeight, mChannels, mFormat, firstLevel };
+	TextureStreamer::AllocateStorage(target, layers, mInterpolation);
+
+	auto const streamer = TextureStreamer::Instance();
+	mPending->layers.reserve(mPaths.size());
+	for (int layer = 0; layer < layers; ++layer)
+	{
+		target.layer = layer;
+		mPending->layers.push_back(streamer->Load(mPaths[static_cast<size_t>(layer)], target));
+	}
+}
+
+//======================================================================================================================
+
+size_t StreamedTexture::ByteSize(int const firstLevel) const
+{
+	int const width = std::max(mWidth >> firstLevel, 1);
+	int const height = std::max(mHeight >> firstLevel, 1);
+	return Mips::ChainSize(width, height, mChannels) * mPaths.size();
+}
+
+//======================================================================================================================
+
+size_t StreamedTexture::ByteSize() const
+{
+	size_t size = 0;
+	for (Storage const* storage : { mCurrent.get(), mPending.get() })
+	{
+		if (storage != nullptr)
+		{
+			size += ByteSize(storage->firstLevel);
+		}
+	}
+	return size;
+}
+
+//======================================================================================================================
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GLHandles.h"
+#include "TextureStreamer.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Storage of a GL_TEXTURE_2D, or of every layer of a GL_TEXTURE_2D_ARRAY, streamed in by the TextureStreamer from a
+// first mip level of the images that can change at runtime. The storage is mutable, allocated level by level with
+// glTexImage, but a new first level changes the size of every level, and redefining them in place would leave the
+// bound texture incomplete until the upload finishes. So it is streamed into new storage while the current one stays
+// bound, then they swap, and the texture never samples missing levels. A placeholder is bound until the first storage
+// is resident
+class StreamedTexture
+{
+public:
+
+	StreamedTexture(GLenum target, int width, int height, int channels, std::vector<std::string> paths, GLint interpolation, int firstLevel = 0);
+
+	StreamedTexture(StreamedTexture const&) = delete;
+	StreamedTexture& operator=(StreamedTexture const&) = delete;
+
+	// The resident storage or the placeholder, after Update()
+	[[nodiscard]]
+	GLuint Texture();
+
+	// Swaps in storage that finished streaming, which frees the previous one
+	void Update();
+
+	[[nodiscard]]
+	bool IsResident() const { return mCurrent != nullptr; }
+
+	// Streams the images from firstLevel into new storage, replacing a stream that is still in progress
+	void StreamFrom(int firstLevel);
+
+	// Level of the images at level 0 of the sampled storage
+	[[nodiscard]]
+	int FirstLevel() const { return mCurrent != nullptr ? mCurrent->firstLevel : TargetLevel(); }
+
+	// First level the texture is streaming to, FirstLevel() when it isn't streaming
+	[[nodiscard]]
+	int TargetLevel() const { return mPending != nullptr ? mPending->firstLevel : mCurrent->firstLevel; }
+
+	// Levels of the full images
+	[[nodiscard]]
+	int LevelCount() const { return mLevelCount; }
+
+	[[nodiscard]]
+	glm::ivec2 Size() const { return { mWidth, mHeight }; }
+
+	// Video memory of every layer when stored from firstLevel
+	[[nodiscard]]
+	size_t ByteSize(int firstLevel) const;
+
+	// Video memory in use, the storage being streamed in included
+	[[nodiscard]]
+	size_t ByteSize() const;
+
+private:
+
+	struct Storage
+	{
+		TextureHandle texture{};
+		std::vector<std::shared_ptr<TextureStreamer::Ticket>> layers{};
+		int firstLevel = 0;
+	};
+
+	GLenum mTarget;
+	int mWidth;
+	int mHeight;
+	int mChannels;
+	GLenum mFormat;
+	int mLevelCount;
+	std::vector<std::string> mPaths;
+	GLint mInterpolation;
+
+	TextureHandle mPlaceholder{};
+	std::unique_ptr<Storage> mCurrent{};
+	std::unique_ptr<Storage> mPending{};
+};
@@ -1,4 +1,9 @@
 #include "Texture.h"
+
+#include "BlockTexture.hpp"
+#include "CompressedImage.hpp"
+#include "ResidencyManager.hpp"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
@@ -7,16 +12,22 @@
 Texture::Texture(std::string path, GLint interpolation)
 	: textureID(), path(path), interpolation(interpolation)
 {
+	// compressed blocks need no decoding, they are uploaded right away
+	std::unique_ptr<CompressedImage> const compressed = CompressedImage::Load(CompressedImage::PathFor(path));
+	if (compressed != nullptr && BlockTexture::IsSupported(compressed->Format()))
+	{
+		width = compressed->Width();
+		height = compressed->Height();
+		byteSize = compressed->Size();
+		BlockTexture::AllocateStorage(GL_TEXTURE_2D, textureID, *compressed, 1, interpolation);
+		BlockTexture::Upload(GL_TEXTURE_2D, textureID, 0, *compressed);
+		return;
+	}
+
 	int numComponents;
-	stbi_set_flip_vertically_on_load(true);
 	const char* pathData = path.c_str();
-	unsigned char* data = stbi_load(pathData, &width, &height, &numComponents, 0);
-	if (data != nullptr)
+	if (stbi_info(pathData, &width, &height, &numComponents) != 0)
 	{
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);		//Set alignment to be 1
-
-		bind();
-
 		//Set number of components by format of the texture
 		GLuint format = GL_RGB;
 		switch (numComponents)
@@ -37,19 +48,11 @@ Texture::Texture(std::string path, GLint interpolation)
 			std::cout << "Invalid Texture Format" << std::endl;
 			break;
 		};
-		//Loads texture data into bound texture
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, interpolation);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, interpolation);
-
-		// Clean up
-		unbind();
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);	//Return to default alignment
-		stbi_image_free(data);
+		int const channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1;
 
+		//Allocates the storage of the mip levels, the pixels are uploaded once decoded
+		streamed = std::make_shared<StreamedTexture>(GL_TEXTURE_2D, width, height, channels, std::vector<std::string>{ path }, interpolation);
+		ResidencyManager::Instance()->Register(streamed);
 	}
 	else {
 		throw std::runtime_error("Failed to read texture data from file!");
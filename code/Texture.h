@@ -1,8 +1,11 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "GLState.hpp"
+#include "StreamedTexture.hpp"
 
 #include <glad/glad.h>
+#include <memory>
 #include <string>
 
 #include <glm/glm.hpp>
@@ -10,6 +13,9 @@
 
 class Texture {
 public:
+	// Uploads the block-compressed version of the image if texture_compressor made one. Otherwise only the image
+	// header is read here and the pixels are streamed in by the TextureStreamer, at the resolution the
+	// ResidencyManager picks
 	Texture(std::string path, GLint interpolation);
 
 	// Because we're using the TextureHandle to do RAII for the texture for us
@@ -27,11 +33,20 @@ public:
 	// the assumption that most students will want to work with ints, not uints, in main.cpp
 	glm::ivec2 getDimensions() const { return glm::uvec2(width, height); }
 
-	void bind() { glBindTexture(GL_TEXTURE_2D, textureID); }
-	void unbind() { glBindTexture(GL_TEXTURE_2D, textureID); }
+	// video memory of the resident mip levels, the placeholder aside
+	size_t getByteSize() const { return streamed != nullptr ? streamed->ByteSize() : byteSize; }
+
+	// null when uploaded at construction
+	std::shared_ptr<StreamedTexture> const& getStreamed() const { return streamed; }
+
+	// binds a placeholder until the image is resident
+	void bind(GLuint const unit = 0) { GLState::BindTexture(unit, GL_TEXTURE_2D, streamed != nullptr ? streamed->Texture() : textureID.value()); }
+	bool isResident() const { return streamed == nullptr || streamed->IsResident(); }
+	void unbind() { GLState::BindTexture(0, GL_TEXTURE_2D, 0); }
 
 private:
-	TextureHandle textureID;
+	TextureHandle textureID; // block-compressed images
+	std::shared_ptr<StreamedTexture> streamed; // other images
 	std::string path;
 	GLint interpolation;
 
@@ -40,6 +55,7 @@ private:
 	// that most students will want to work with ints, not uints, in main.cpp
 	int width;
 	int height;
+	size_t byteSize = 0;
 
 
 
@@ -0,0 +1,145 @@
+#include "TextureArray.hpp"
+
+#include "BlockTexture.hpp"
+#include "MipChain.hpp"
+#include "ResidencyManager.hpp"
+
+#include "Log.h"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+
+//======================================================================================================================
+
+TextureArray::TextureArray(
+	int const width,
+	int const height,
+	int const channels,
+	std::vector<std::string> const& paths,
+	GLint const interpolation
+)
+	: mWidth(width)
+	, mHeight(height)
+	, mLayerCount(static_cast<int>(paths.size()))
+{
+	mStreamed = std::make_shared<StreamedTexture>(GL_TEXTURE_2D_ARRAY, width, height, channels, paths, interpolation);
+	ResidencyManager::Instance()->Register(mStreamed);
+
+	Log::info("Texture array: {} layers of {}x{}", mLayerCount, width, height);
+}
+
+//======================================================================================================================
+
+TextureArray::TextureArray(
+	BlockFormat const format,
+	int const width,
+	int const height,
+	std::vector<std::string> const& paths,
+	GLint const interpolation
+)
+	: mWidth(width)
+	, mHeight(height)
+	, mLayerCount(static_cast<int>(paths.size()))
+{
+	for (int layer = 0; layer < mLayerCount; ++layer)
+	{
+		std::unique_ptr<CompressedImage> const image = CompressedImage::Load(paths[layer]);
+		if (image == nullptr || image->Format() != format || image->Width() != width || image->Height() != height)
+		{
+			throw std::runtime_error("Compressed texture array layer changed since it was added: " + paths[layer]);
+		}
+		if (layer == 0)
+		{
+			BlockTexture::AllocateStorage(GL_TEXTURE_2D_ARRAY, mTexture, *image, mLayerCount, interpolation);
+			mByteSize = image->Size() * paths.size();
+		}
+		BlockTexture::Upload(GL_TEXTURE_2D_ARRAY, mTexture, layer, *image);
+	}
+
+	Log::info("Texture array: {} {} layers of {}x{}", mLayerCount, BlockFormats::Name(format), width, height);
+}
+
+//======================================================================================================================
+
+void TextureArray::Bind(GLuint const unit) const
+{
+	GLState::BindTexture(unit, GL_TEXTURE_2D_ARRAY, mStreamed != nullptr ? mStreamed->Texture() : mTexture.value());
+}
+
+//======================================================================================================================
+
+TextureArrayBuilder::Slot TextureArrayBuilder::Add(std::string const& path)
+{
+	auto const found = mSlots.find(path);
+	if (found != mSlots.end())
+	{
+		return found->second;
+	}
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	std::optional<BlockFormat> format{};
+
+	// layers of a compressed array all need every level, partial chains fall back to the source image. Only the
+	// header is read here, the levels are mapped when the array is built
+	std::string const compressedPath = CompressedImage::PathFor(path);
+	std::optional<CompressedImage::Info> const compressed = CompressedImage::Probe(compressedPath);
+	if (compressed.has_value() && BlockTexture::IsSupported(compressed->format)
+		&& compressed->levelCount == Mips::LevelCount(compressed->width, compressed->height))
+	{
+		width = compressed->width;
+		height = compressed->height;
+		format = compressed->format;
+	}
+	else if (stbi_info(path.c_str(), &width, &height, &channels) == 0)
+	{
+		throw std::runtime_error("Failed to read texture header from file: " + path);
+	}
+
+	size_t array = 0;
+	while (array < mGroups.size())
+	{
+		Group const& group = mGroups[array];
+		if (group.width == width && group.height == height && group.channels == channels && group.format == format)
+		{
+			break;
+		}
+		++array;
+	}
+	if (array == mGroups.size())
+	{
+		mGroups.push_back(Group{ width, height, channels, format, {} });
+	}
+
+	Group& group = mGroups[array];
+	Slot const slot{ array, static_cast<int>(group.paths.size()) };
+	group.paths.push_back(format.has_value() ? compressedPath : path);
+	mSlots.emplace(path, slot);
+	return slot;
+}
+
+//======================================================================================================================
+
+std::vector<std::unique_ptr<TextureArray>> TextureArrayBuilder::Build(GLint const interpolation) const
+{
+	std::vector<std::unique_ptr<TextureArray>> arrays{};
+	arrays.reserve(mGroups.size());
+	for (Group const& group : mGroups)
+	{
+		if (group.format.has_value())
+		{
+			arrays.push_back(std::make_unique<TextureArray>(*group.format, group.width, group.height, group.paths, interpolation));
+		}
+		else
+		{
+			arrays.push_back(std::make_unique<TextureArray>(group.width, group.height, group.channels, group.paths, interpolation));
+		}
+	}
+	return arrays;
+}
+
+//======================================================================================================================
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CompressedImage.hpp"
+#include "GLHandles.h"
+#include "GLState.hpp"
+#include "StreamedTexture.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Images of the same size and channel count stored as layers of one GL_TEXTURE_2D_ARRAY, so draws sampling different
+// images can share a single texture binding. The layers are streamed in by the TextureStreamer, at the resolution the
+// ResidencyManager picks for the whole array
+class TextureArray
+{
+public:
+
+	TextureArray(int width, int height, int channels, std::vector<std::string> const& paths, GLint interpolation);
+
+	// Layers from block-compressed files with full mip chains, uploaded right away
+	TextureArray(BlockFormat format, int width, int height, std::vector<std::string> const& paths, GLint interpolation);
+
+	// Binds a placeholder array until every layer is resident
+	void Bind(GLuint unit) const;
+
+	[[nodiscard]]
+	bool IsResident() const { return mStreamed == nullptr || mStreamed->IsResident(); }
+
+	// Null for block-compressed layers, they are uploaded at construction
+	[[nodiscard]]
+	std::shared_ptr<StreamedTexture> const& Streamed() const { return mStreamed; }
+
+	[[nodiscard]]
+	glm::ivec2 Dimensions() const { return { mWidth, mHeight }; }
+
+	[[nodiscard]]
+	int LayerCount() const { return mLayerCount; }
+
+	// Video memory of the resident levels of every layer
+	[[nodiscard]]
+	size_t ByteSize() const { return mStreamed != nullptr ? mStreamed->ByteSize() : mByteSize; }
+
+private:
+
+	TextureHandle mTexture{}; // block-compressed layers
+	std::shared_ptr<StreamedTexture> mStreamed{}; // other layers
+	int mWidth;
+	int mHeight;
+	int mLayerCount;
+	size_t mByteSize = 0;
+};
+
+// Collects images and groups the compatible ones into texture arrays
+class TextureArrayBuilder
+{
+public:
+
+	struct Slot
+	{
+		size_t array = 0; // index in the vector returned by Build
+		int layer = 0;
+	};
+
+	// Reserves a layer for the image, only its header is read here. The block-compressed version of the image is used
+	// when there is one. Adding the same path again returns the same slot
+	Slot Add(std::string const& path);
+
+	// Creates one texture array per group of compatible images and loads every image into its layer
+	[[nodiscard]]
+	std::vector<std::unique_ptr<TextureArray>> Build(GLint interpolation) const;
+
+private:
+
+	struct Group
+	{
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		std::optional<BlockFormat> format{}; // of the compressed files, paths then are those files
+		std::vector<std::string> paths{};
+	};
+
+	std::vector<Group> mGroups{};
+	std::unordered_map<std::string, Slot> mSlots{};
+};
@@ -0,0 +1,83 @@
+#include "TextureCache.hpp"
+
+#include <algorithm>
+
+//======================================================================================================================
+
+std::shared_ptr<TextureCache> TextureCache::Instance()
+{
+	std::shared_ptr<TextureCache> shared_ptr = _instance.lock();
+	if (shared_ptr == nullptr)
+	{
+		shared_ptr = std::make_shared<TextureCache>();
+		_instance = shared_ptr;
+	}
+	return shared_ptr;
+}
+
+//======================================================================================================================
+
+std::shared_ptr<Texture> TextureCache::Load(std::string const& path, GLint const interpolation)
+{
+	std::weak_ptr<Texture>& cached = mTextures[Key{ path, interpolation }];
+	std::shared_ptr<Texture> texture = cached.lock();
+	if (texture == nullptr)
+	{
+		texture = std::make_shared<Texture>(path, interpolation);
+		cached = texture;
+	}
+	return texture;
+}
+
+//======================================================================================================================
+
+std::vector<TextureCache::Entry> TextureCache::Report()
+{
+	RemoveExpired();
+
+	std::vector<Entry> entries{};
+	entries.reserve(mTextures.size());
+	for (auto const& [key, cached] : mTextures)
+	{
+		std::shared_ptr<Texture> const texture = cached.lock();
+		if (texture != nullptr)
+		{
+			// the handle locked here is not a user
+			entries.push_back({ key.first, key.second, texture->getByteSize(), texture.use_count() - 1, texture->isResident() });
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b)->bool
+	{
+		return a.bytes > b.bytes;
+	});
+	return entries;
+}
+
+//======================================================================================================================
+
+size_t TextureCache::ByteSize()
+{
+	RemoveExpired();
+
+	size_t size = 0;
+	for (auto const& [key, cached] : mTextures)
+	{
+		if (std::shared_ptr<Texture> const texture = cached.lock())
+		{
+			size += texture->getByteSize();
+		}
+	}
+	return size;
+}
+
+//======================================================================================================================
+
+void TextureCache::RemoveExpired()
+{
+	for (auto it = mTextures.begin(); it != mTextures.end();)
+	{
+		it = it->second.expired() ? mTextures.erase(it) : std::next(it);
+	}
+}
+
+//======================================================================================================================
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Texture.h"
+
+#include <glad/glad.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shares textures between everything that samples the same image with the same filtering. A texture lives as long as
+// someone holds its handle, loading it again meanwhile returns the same texture, also while it is still streaming in,
+// so each image is decoded and uploaded once. Only used on the GL thread
+class TextureCache
+{
+public:
+
+	struct Entry
+	{
+		std::string path{};
+		GLint interpolation = GL_LINEAR;
+		size_t bytes = 0;   // video memory of all mip levels
+		long users = 0;     // handles held outside the cache
+		bool resident = false;
+	};
+
+	// GL thread only, like every use of the instance
+	static std::shared_ptr<TextureCache> Instance();
+
+	// Returns the texture loaded for path and interpolation, or starts loading it
+	[[nodiscard]]
+	std::shared_ptr<Texture> Load(std::string const& path, GLint interpolation);
+
+	// Textures alive right now, largest first
+	[[nodiscard]]
+	std::vector<Entry> Report();
+
+	// Video memory of the textures alive right now
+	[[nodiscard]]
+	size_t ByteSize();
+
+private:
+
+	using Key = std::pair<std::string, GLint>;
+
+	void RemoveExpired();
+
+	inline static std::weak_ptr<TextureCache> _instance{};
+
+	std::map<Key, std::weak_ptr<Texture>> mTextures{};
+};
@@ -0,0 +1,390 @@
+#include "TextureStreamer.hpp"
+
+#include "GLState.hpp"
+#include "Log.h"
+#include "MipDiskCache.hpp"
+#include "ThreadPool.hpp"
+
+#include <GLFW/glfw3.h>
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+//======================================================================================================================
+
+std::shared_ptr<TextureStreamer> TextureStreamer::Instance()
+{
+	std::shared_ptr<TextureStreamer> shared_ptr = _instance.lock();
+	if (shared_ptr == nullptr)
+	{
+		shared_ptr = std::make_shared<TextureStreamer>();
+		_instance = shared_ptr;
+	}
+	return shared_ptr;
+}
+
+//======================================================================================================================
+
+TextureStreamer::TextureStreamer(size_t const regionSize)
+	: mPool(ThreadPool::Instance())
+	, mRegionSize(regionSize)
+{
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(mRegionSize * FramesInFlight), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+//======================================================================================================================
+
+TextureStreamer::~TextureStreamer()
+{
+	// decodes that did not start yet return right away, the running ones have to finish before this is gone
+	mStopping = true;
+	for (std::future<void>& decode : mDecodes)
+	{
+		decode.wait();
+	}
+
+	for (GLsync const fence : mFences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+		}
+	}
+}
+
+//======================================================================================================================
+
+std::shared_ptr<TextureStreamer::Ticket> TextureStreamer::Load(std::string const& path, Target const& target)
+{
+	auto ticket = std::make_shared<Ticket>();
+	std::weak_ptr<Ticket> weakTicket = ticket;
+	mDecodes.push_back(mPool->Submit([this, path, weakTicket, target]()->void
+	{
+		Decode(path, weakTicket, target);
+	}));
+	++mPendingCount;
+	return ticket;
+}
+
+//======================================================================================================================
+
+std::shared_ptr<TextureStreamer::Ticket> TextureStreamer::Load(std::shared_ptr<MipChain const> chain, Target const& target)
+{
+	auto ticket = std::make_shared<Ticket>();
+	Decoded decoded{};
+	decoded.ticket = ticket;
+	decoded.target = target;
+	decoded.chain = std::move(chain);
+	decoded.level = static_cast<size_t>(target.firstLevel);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mDecoded.push_back(std::move(decoded));
+	}
+	++mPendingCount;
+	return ticket;
+}
+
+//======================================================================================================================
+
+void TextureStreamer::Decode(std::string const& path, std::weak_ptr<Ticket> const& ticket, Target const& target)
+{
+	Decoded decoded{};
+	decoded.ticket = ticket;
+	decoded.target = target;
+	decoded.level = static_cast<size_t>(target.firstLevel);
+
+	if (mStopping == false && ticket.expired() == false)
+	{
+		decoded.chain = mMipCache.Find(path, target.channels);
+	}
+
+	// a warm start maps the chain from the disk cache instead of decoding the image
+	uint64_t sourceHash = 0;
+	if (decoded.chain == nullptr && mStopping == false && ticket.expired() == false)
+	{
+		sourceHash = MipDiskCache::SourceHash(path);
+		std::shared_ptr<MipChain const> chain = sourceHash != 0 ? MipDiskCache::Load(path, sourceHash, target.channels) : nullptr;
+		if (chain != nullptr && chain->levels[0].width == target.width && chain->levels[0].height == target.height)
+		{
+			mMipCache.Insert(path, target.channels, chain);
+			decoded.chain = std::move(chain);
+		}
+	}
+
+	if (decoded.chain == nullptr && mStopping == false && ticket.expired() == false)
+	{
+		stbi_set_flip_vertically_on_load_thread(true);
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		stbi_uc* const pixels = stbi_load(path.c_str(), &width, &height, &channels, target.channels);
+		if (pixels == nullptr)
+		{
+			decoded.error = "Failed to read texture data from file: " + path;
+		}
+		else if (width != target.width || height != target.height)
+		{
+			stbi_image_free(pixels);
+			decoded.error = "Texture has a different size than its storage: " + path;
+		}
+		else
+		{
+			std::shared_ptr<MipChain const> chain = Mips::Build(pixels, width, height, target.channels, *mPool);
+			stbi_image_free(pixels);
+			if (sourceHash != 0)
+			{
+				MipDiskCache::Store(path, sourceHash, *chain);
+			}
+			mMipCache.Insert(path, target.channels, chain);
+			decoded.chain = std::move(chain);
+		}
+	}
+
+	// results are handed over even when cancelled, Update keeps the pending count
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDecoded.push_back(std::move(decoded));
+}
+
+//======================================================================================================================
+
+std::byte* TextureStreamer::BeginRegion()
+{
+	mRegion = (mRegion + 1) % FramesInFlight;
+
+	GLsync& fence = mFences[mRegion];
+	if (fence != nullptr)
+	{
+		// normally signaled already, the region was last used frames ago
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+	void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, static_cast<GLintptr>(mRegion * mRegionSize), static_cast<GLsizeiptr>(mRegionSize), flags);
+	return static_cast<std::byte*>(data);
+}
+
+//======================================================================================================================
+
+void TextureStreamer::Update()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		while (mDecoded.empty() == false)
+		{
+			mUploads.push_back(std::move(mDecoded.front()));
+			mDecoded.pop_front();
+		}
+	}
+
+	mDecodes.erase(std::remove_if(mDecodes.begin(), mDecodes.end(), [](std::future<void> const& decode)->bool
+	{
+		return decode.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}), mDecodes.end());
+
+	// failed and cancelled requests never become resident, failed ones keep their placeholder
+	mUploads.erase(std::remove_if(mUploads.begin(), mUploads.end(), [this](Decoded const& decoded)->bool
+	{
+		if (decoded.chain != nullptr && decoded.ticket.expired() == false)
+		{
+			return false;
+		}
+		if (decoded.error.empty() == false)
+		{
+			Log::error("{}", decoded.error);
+		}
+		--mPendingCount;
+		return true;
+	}), mUploads.end());
+
+	if (mUploads.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+	std::byte* const region = BeginRegion();
+	size_t const regionOffset = mRegion * mRegionSize;
+
+	// copy whole rows of the levels in order until the region is full, the image that does not fit continues next frame
+	mCopies.clear();
+	size_t used = 0;
+	while (mUploads.empty() == false)
+	{
+		Decoded& upload = mUploads.front();
+		std::shared_ptr<Ticket> ticket = upload.ticket.lock();
+		if (ticket == nullptr)
+		{
+			--mPendingCount;
+			mUploads.pop_front();
+			continue;
+		}
+
+		MipChain const& chain = *upload.chain;
+		MipChain::Level const& level = chain.levels[upload.level];
+		size_t const rowSize = chain.RowSize(upload.level);
+		size_t const fittingRows = (mRegionSize - used) / rowSize;
+		int const rowCount = static_cast<int>(std::min<size_t>(fittingRows, static_cast<size_t>(level.height - upload.uploadedRows)));
+		if (rowCount == 0)
+		{
+			break;
+		}
+
+		size_t const size = rowSize * static_cast<size_t>(rowCount);
+		std::memcpy(region + used, chain.Data(upload.level) + rowSize * static_cast<size_t>(upload.uploadedRows), size);
+		bool const levelDone = upload.uploadedRows + rowCount == level.height;
+		bool const last = levelDone && upload.level + 1 == chain.levels.size();
+		size_t const textureLevel = upload.level - static_cast<size_t>(upload.target.firstLevel);
+		mCopies.push_back({ std::move(ticket), upload.target, textureLevel, level.width, upload.uploadedRows, rowCount, regionOffset + used, last });
+		used += size;
+		upload.uploadedRows += rowCount;
+
+		if (levelDone)
+		{
+			upload.level++;
+			upload.uploadedRows = 0;
+		}
+		if (last)
+		{
+			mUploads.pop_front();
+		}
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	// with a pixel unpack buffer bound the data pointer is an offset into it
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (Copy const& copy : mCopies)
+	{
+		Target const& target = copy.target;
+		auto const* const offset = reinterpret_cast<void const*>(copy.offset);
+		auto const level = static_cast<GLint>(copy.level);
+		GLState::BindTexture(0, target.target, target.texture);
+		if (target.target == GL_TEXTURE_2D_ARRAY)
+		{
+			glTexSubImage3D(target.target, level, 0, copy.firstRow, target.layer, copy.width, copy.rowCount, 1, target.format, GL_UNSIGNED_BYTE, offset);
+		}
+		else if (target.target == GL_TEXTURE_CUBE_MAP)
+		{
+			GLenum const face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(target.layer);
+			glTexSubImage2D(face, level, 0, copy.firstRow, copy.width, copy.rowCount, target.format, GL_UNSIGNED_BYTE, offset);
+		}
+		else
+		{
+			glTexSubImage2D(target.target, level, 0, copy.firstRow, copy.width, copy.rowCount, target.format, GL_UNSIGNED_BYTE, offset);
+		}
+
+		if (copy.last)
+		{
+			// later draws are ordered after the upload by GL, the texture can be sampled from now on
+			copy.ticket->mResident = true;
+			--mPendingCount;
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mCopies.clear();
+}
+
+//======================================================================================================================
+
+void TextureStreamer::AllocateStorage(Target const& target, int const layers, GLint const interpolation)
+{
+	GLState::BindTexture(0, target.target, target.texture);
+	auto const internalFormat = static_cast<GLint>(target.format);
+	int const levelCount = Mips::LevelCount(target.width, target.height) - target.firstLevel;
+	int width = std::max(target.width >> target.firstLevel, 1);
+	int height = std::max(target.height >> target.firstLevel, 1);
+	for (int level = 0; level < levelCount; ++level)
+	{
+		if (target.target == GL_TEXTURE_2D_ARRAY)
+		{
+			glTexImage3D(target.target, level, internalFormat, width, height, layers, 0, target.format, GL_UNSIGNED_BYTE, nullptr);
+		}
+		else if (target.target == GL_TEXTURE_CUBE_MAP)
+		{
+			for (GLenum face = 0; face < 6; ++face)
+			{
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, internalFormat, width, height, 0, target.format, GL_UNSIGNED_BYTE, nullptr);
+			}
+		}
+		else
+		{
+			glTexImage2D(target.target, level, internalFormat, width, height, 0, target.format, GL_UNSIGNED_BYTE, nullptr);
+		}
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+
+	SetFiltering(target.target, levelCount, interpolation);
+	GLState::BindTexture(0, target.target, 0);
+}
+
+//======================================================================================================================
+
+void TextureStreamer::SetFiltering(GLenum const target, int const levelCount, GLint const interpolation)
+{
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, interpolation);
+	if (interpolation == GL_NEAREST)
+	{
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		return;
+	}
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	// core since 4.6, the extension has the same values and is available nearly everywhere
+	constexpr GLenum MaxAnisotropy = 0x84FE;        // GL_TEXTURE_MAX_ANISOTROPY
+	constexpr GLenum MaxAnisotropyLimit = 0x84FF;   // GL_MAX_TEXTURE_MAX_ANISOTROPY
+	static bool const supported = glfwExtensionSupported("GL_ARB_texture_filter_anisotropic") == GLFW_TRUE
+		|| glfwExtensionSupported("GL_EXT_texture_filter_anisotropic") == GLFW_TRUE;
+	if (supported)
+	{
+		GLfloat limit = 1.0f;
+		glGetFloatv(MaxAnisotropyLimit, &limit);
+		glTexParameterf(target, MaxAnisotropy, std::min(limit, 16.0f));
+	}
+}
+
+//======================================================================================================================
+
+void TextureStreamer::CreatePlaceholder(GLenum const target, GLuint const texture, int const layers, GLenum const format)
+{
+	// the texel is stored with the channel count of the real texture, formats without alpha read an alpha of 1
+	constexpr unsigned char texel[4] = { 96, 96, 96, 0 };
+	size_t const channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1;
+	std::vector<unsigned char> texels{};
+	for (int layer = 0; layer < layers; ++layer)
+	{
+		texels.insert(texels.end(), texel, texel + channels);
+	}
+
+	GLState::BindTexture(0, target, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (target == GL_TEXTURE_2D_ARRAY)
+	{
+		glTexImage3D(target, 0, static_cast<GLint>(format), 1, 1, layers, 0, format, GL_UNSIGNED_BYTE, texels.data());
+	}
+	else
+	{
+		glTexImage2D(target, 0, static_cast<GLint>(format), 1, 1, 0, format, GL_UNSIGNED_BYTE, texels.data());
+	}
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	GLState::BindTexture(0, target, 0);
+}
+
+//======================================================================================================================
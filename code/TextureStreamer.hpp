@@ -0,0 +1,146 @@
+#pragma once
+
+#include "GLHandles.h"
+#include "MipChain.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Loads images into textures in the background. Images are decoded and their mip chains built on the ThreadPool, or
+// mapped from the MipDiskCache when an earlier run built them already, then uploaded on the GL thread through a ring of
+// pixel buffers, at most one region of the ring per frame, so a large image is spread over several frames instead of
+// stalling one. Textures bind a placeholder until their ticket reports them
+// resident.
+//
+// Usage: AllocateStorage(), Load() each image, call Update() once per frame on the GL thread
+class TextureStreamer
+{
+public:
+
+	static constexpr size_t FramesInFlight = 3;
+	static constexpr size_t DefaultRegionSize = 8 * 1024 * 1024; // upload budget per frame in bytes
+
+	// Residency of one requested image, dropping the ticket cancels the request
+	class Ticket
+	{
+	public:
+
+		[[nodiscard]]
+		bool IsResident() const { return mResident; }
+
+	private:
+
+		friend class TextureStreamer;
+		bool mResident = false; // only touched on the GL thread
+	};
+
+	// Where a decoded image goes, every mip level of a GL_TEXTURE_2D, of one layer of a GL_TEXTURE_2D_ARRAY or of one
+	// face of a GL_TEXTURE_CUBE_MAP, the layer is the face
+	struct Target
+	{
+		GLenum target = GL_TEXTURE_2D;
+		GLuint texture = 0;
+		int layer = 0;
+		int width = 0;
+		int height = 0;
+		int channels = 0; // the image is converted to this many channels while decoding
+		GLenum format = GL_RGB;
+		int firstLevel = 0; // level of the image stored as level 0 of the texture, width and height are the image's
+	};
+
+	// GL thread only, like every use of the instance
+	static std::shared_ptr<TextureStreamer> Instance();
+
+	// Needs a current GL context
+	explicit TextureStreamer(size_t regionSize = DefaultRegionSize);
+
+	~TextureStreamer();
+
+	TextureStreamer(TextureStreamer const&) = delete;
+	TextureStreamer& operator=(TextureStreamer const&) = delete;
+
+	// Queues the decode of the image at path, target must have storage from AllocateStorage
+	[[nodiscard]]
+	std::shared_ptr<Ticket> Load(std::string const& path, Target const& target);
+
+	// Queues the upload of a chain built elsewhere, the target's size has to be the chain's
+	[[nodiscard]]
+	std::shared_ptr<Ticket> Load(std::shared_ptr<MipChain const> chain, Target const& target);
+
+	// Uploads decoded images within the budget of one region, call once per frame on the GL thread
+	void Update();
+
+	// Images requested but not resident yet
+	[[nodiscard]]
+	size_t PendingCount() const { return mPendingCount; }
+
+	// Allocates every mip level from the target's first level, of every layer of a GL_TEXTURE_2D_ARRAY or every face of
+	// a GL_TEXTURE_CUBE_MAP, and sets the filtering. GL_LINEAR interpolation filters trilinearly, and anisotropically
+	// where supported, GL_NEAREST picks the nearest texel of the nearest level
+	static void AllocateStorage(Target const& target, int layers, GLint interpolation);
+
+	// Filtering of AllocateStorage for the texture bound to target on unit 0
+	static void SetFiltering(GLenum target, int levelCount, GLint interpolation);
+
+	// Creates 1x1 storage with a neutral texel for every layer. The texel has zero alpha when the format has alpha,
+	// the basic shader discards those fragments so blended textures disappear instead of showing the placeholder
+	static void CreatePlaceholder(GLenum target, GLuint texture, int layers, GLenum format);
+
+private:
+
+	struct Decoded
+	{
+		std::weak_ptr<Ticket> ticket{};
+		Target target{};
+		std::shared_ptr<MipChain const> chain{};
+		std::string error{}; // set when decoding failed
+		size_t level = 0; // of the image, being uploaded
+		int uploadedRows = 0; // of that level
+	};
+
+	struct Copy
+	{
+		std::shared_ptr<Ticket> ticket{};
+		Target target{};
+		size_t level = 0; // of the texture
+		int width = 0;
+		int firstRow = 0;
+		int rowCount = 0;
+		size_t offset = 0; // in the mapped region
+		bool last = false;
+	};
+
+	void Decode(std::string const& path, std::weak_ptr<Ticket> const& ticket, Target const& target);
+
+	std::byte* BeginRegion();
+
+	inline static std::weak_ptr<TextureStreamer> _instance{};
+
+	std::shared_ptr<ThreadPool> mPool{};
+	std::vector<std::future<void>> mDecodes{};
+	std::atomic<bool> mStopping{ false };
+
+	std::mutex mMutex{};
+	std::deque<Decoded> mDecoded{}; // guarded by mMutex, filled by the workers
+	MipCache mMipCache{};
+
+	std::deque<Decoded> mUploads{};
+	std::vector<Copy> mCopies{};
+	size_t mPendingCount = 0;
+
+	VertexBufferHandle mBuffer{};
+	size_t mRegionSize;
+	size_t mRegion = 0;
+	std::array<GLsync, FramesInFlight> mFences{};
+};
@@ -0,0 +1,141 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+//======================================================================================================================
+
+std::shared_ptr<ThreadPool> ThreadPool::Instance()
+{
+	static std::shared_ptr<ThreadPool> const instance = std::make_shared<ThreadPool>();
+	return instance;
+}
+
+//======================================================================================================================
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		size_t const hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = std::max<size_t>(hardwareThreads, 2) - 1;
+	}
+
+	mWorkers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		mWorkers.emplace_back([this]()->void { WorkerLoop(); });
+	}
+}
+
+//======================================================================================================================
+
+ThreadPool::~ThreadPool()
+{
+	// queued tasks are dropped instead of run, their futures report a broken promise. Tasks already running finish
+	std::deque<std::function<void()>> dropped{};
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+		dropped.swap(mTasks);
+	}
+	mCondition.notify_all();
+	dropped.clear();
+
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+//======================================================================================================================
+
+void ThreadPool::ParallelFor(int const begin, int const end, int const grainSize, std::function<void(int, int)> const& body)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+
+	int const chunkSize = std::max(grainSize, 1);
+	int const chunkCount = (end - begin + chunkSize - 1) / chunkSize;
+	if (chunkCount == 1 || mWorkers.empty())
+	{
+		body(begin, end);
+		return;
+	}
+
+	// Shared with the helper tasks, a helper may only start after all chunks were already taken
+	struct State
+	{
+		std::atomic<int> nextChunk{ 0 };
+		int completedChunks = 0;
+		std::mutex mutex{};
+		std::condition_variable done{};
+	};
+	auto state = std::make_shared<State>();
+
+	auto const runChunks = [state, &body, begin, end, chunkSize, chunkCount]()->void
+	{
+		for (int chunk = state->nextChunk++; chunk < chunkCount; chunk = state->nextChunk++)
+		{
+			int const chunkBegin = begin + chunk * chunkSize;
+			body(chunkBegin, std::min(chunkBegin + chunkSize, end));
+
+			std::lock_guard<std::mutex> lock(state->mutex);
+			if (++state->completedChunks == chunkCount)
+			{
+				state->done.notify_all();
+			}
+		}
+	};
+
+	// helpers only touch body while there are unclaimed chunks, which can't outlive this call
+	size_t const helperCount = std::min(mWorkers.size(), static_cast<size_t>(chunkCount - 1));
+	for (size_t i = 0; i < helperCount; i++)
+	{
+		Enqueue(runChunks);
+	}
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [&state, chunkCount]()->bool { return state->completedChunks == chunkCount; });
+}
+
+//======================================================================================================================
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mStopping)
+		{
+			return; // dropped like the tasks queued before the pool stopped
+		}
+		mTasks.emplace_back(std::move(task));
+	}
+	mCondition.notify_one();
+}
+
+//======================================================================================================================
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task{};
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]()->bool { return mStopping || mTasks.empty() == false; });
+			if (mStopping)
+			{
+				return;
+			}
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+		}
+		task();
+	}
+}
+
+//======================================================================================================================
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads shared by the CPU heavy jobs (geometry generation, image decoding, ...)
+class ThreadPool
+{
+public:
+
+	// Created on first use from any thread and kept until the process exits, so it is never released on one of its
+	// own workers. Jobs running on the pool get it passed in instead of looking it up
+	static std::shared_ptr<ThreadPool> Instance();
+
+	// threadCount of 0 uses one thread per hardware thread, minus the calling thread
+	explicit ThreadPool(size_t threadCount = 0);
+
+	// Waits for the running tasks, the queued ones are dropped
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	[[nodiscard]]
+	size_t ThreadCount() const { return mWorkers.size(); }
+
+	template <typename Function>
+	[[nodiscard]]
+	std::future<std::invoke_result_t<Function>> Submit(Function&& function)
+	{
+		using Result = std::invoke_result_t<Function>;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+		std::future<Result> future = task->get_future();
+		Enqueue([task]()->void { (*task)(); });
+		return future;
+	}
+
+	// Splits [begin, end) into chunks of at most grainSize and calls body(chunkBegin, chunkEnd) for each of them.
+	// The calling thread takes part and the call returns once every chunk is done, so it is safe to call from a worker.
+	void ParallelFor(int begin, int end, int grainSize, std::function<void(int chunkBegin, int chunkEnd)> const& body);
+
+private:
+
+	void Enqueue(std::function<void()> task);
+
+	void WorkerLoop();
+
+	std::vector<std::thread> mWorkers{};
+	std::deque<std::function<void()>> mTasks{};
+	std::mutex mMutex{};
+	std::condition_variable mCondition{};
+	bool mStopping = false;
+};
@@ -0,0 +1,120 @@
+#include "UniformRing.hpp"
+
+#include "Log.h"
+
+//======================================================================================================================
+
+UniformRing::UniformRing(size_t const blockSize, size_t const blockCount)
+{
+	// each block, and with it each region, has to start at an offset the driver accepts for glBindBufferRange
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	size_t const alignmentSize = static_cast<size_t>(alignment);
+	mBlockSize = (blockSize + alignmentSize - 1) / alignmentSize * alignmentSize;
+	mRegionSize = mBlockSize * blockCount;
+
+	GLsizeiptr const totalSize = static_cast<GLsizeiptr>(mRegionSize * FramesInFlight);
+	glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+
+#if defined(GL_VERSION_4_4)
+	if (GLAD_GL_VERSION_4_4)
+	{
+		GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr, flags);
+		mPersistentData = static_cast<std::byte*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize, flags));
+	}
+#endif
+
+	if (mPersistentData == nullptr)
+	{
+		glBufferData(GL_UNIFORM_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	Log::info("Uniform ring: {} regions of {} bytes, {}", FramesInFlight, mRegionSize, IsPersistent() ? "persistently mapped" : "mapped per frame");
+}
+
+//======================================================================================================================
+
+UniformRing::~UniformRing()
+{
+	for (GLsync const fence : mFences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+		}
+	}
+
+	if (mPersistentData != nullptr || mMapped)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+}
+
+//======================================================================================================================
+
+std::byte* UniformRing::BeginFrame()
+{
+	mRegion = (mRegion + 1) % FramesInFlight;
+
+	GLsync& fence = mFences[mRegion];
+	if (fence != nullptr)
+	{
+		// normally signaled already, frames in flight are there so we rarely wait
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	size_t const offset = mRegion * mRegionSize;
+	if (mPersistentData != nullptr)
+	{
+		return mPersistentData + offset;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+	GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+	void* data = glMapBufferRange(GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(mRegionSize), flags);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	mMapped = true;
+	return static_cast<std::byte*>(data);
+}
+
+//======================================================================================================================
+
+void UniformRing::Flush()
+{
+	if (mMapped == false)
+	{
+		return; // coherent persistent mappings need no flush
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+	glUnmapBuffer(GL_UNIFORM_BUFFER);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	mMapped = false;
+}
+
+//======================================================================================================================
+
+void UniformRing::Bind(GLuint const binding, size_t const block) const
+{
+	size_t const offset = mRegion * mRegionSize + block * mBlockSize;
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, mBuffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(mBlockSize));
+}
+
+//======================================================================================================================
+
+void UniformRing::EndFrame()
+{
+	mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+//======================================================================================================================
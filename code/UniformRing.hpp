@@ -0,0 +1,65 @@
+#pragma once
+
+#include "GLHandles.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+
+// Uniform buffer split into one region per frame in flight, used to stream per-draw data.
+// A fence guards each region so the CPU never writes data the GPU may still be reading.
+//
+// On GL 4.4+ (modern loader) the buffer is persistently mapped once. Otherwise each region is mapped unsynchronized
+// for the frame, the fence already did the synchronization, and unmapped by Flush().
+//
+// A region holds one or more blocks, each block is the range bound to a uniform block binding point. Blocks start at
+// multiples of BlockSize() from the pointer returned by BeginFrame().
+//
+// Usage per frame: BeginFrame() -> write -> Flush() -> Bind() -> draw -> EndFrame()
+class UniformRing
+{
+public:
+
+	static constexpr size_t FramesInFlight = 3;
+
+	explicit UniformRing(size_t blockSize, size_t blockCount = 1);
+
+	~UniformRing();
+
+	UniformRing(UniformRing const&) = delete;
+	UniformRing& operator=(UniformRing const&) = delete;
+
+	// Waits until the GPU is done with the next region and returns a pointer to write it
+	[[nodiscard]]
+	std::byte* BeginFrame();
+
+	// Makes the written data visible to the GPU
+	void Flush();
+
+	// Binds a block of the current region to a uniform block binding point
+	void Bind(GLuint binding, size_t block = 0) const;
+
+	// Marks the current region as in use by the commands submitted so far
+	void EndFrame();
+
+	[[nodiscard]]
+	size_t RegionSize() const { return mRegionSize; }
+
+	// Distance between the starts of consecutive blocks, the block size rounded up to the binding offset alignment
+	[[nodiscard]]
+	size_t BlockSize() const { return mBlockSize; }
+
+	[[nodiscard]]
+	bool IsPersistent() const { return mPersistentData != nullptr; }
+
+private:
+
+	VertexBufferHandle mBuffer{};
+	size_t mBlockSize;
+	size_t mRegionSize;
+	size_t mRegion = 0;
+	std::byte* mPersistentData = nullptr;
+	bool mMapped = false;
+	std::array<GLsync, FramesInFlight> mFences{};
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "GLState.hpp"
 
 #include <glad/glad.h>
 
@@ -17,7 +18,7 @@ public:
 	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
 
 	// Public interface
-	void bind() const { glBindVertexArray(arrayID); }
+	void bind() const { GLState::BindVertexArray(arrayID); }
 
 private:
 	VertexArrayHandle arrayID;
@@ -19,12 +19,10 @@ void VertexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
 
 //======================================================================================================================
 
-IndexBuffer::IndexBuffer(GLuint index, GLint size, GLenum dataType)
+IndexBuffer::IndexBuffer()
     : bufferID{}
 {
     bind();
-    glVertexAttribPointer(index, size, dataType, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(index);
 }
 
 void IndexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
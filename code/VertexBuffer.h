@@ -28,7 +28,8 @@ private:
 class IndexBuffer {
 
 public:
-    IndexBuffer(GLuint index, GLint size, GLenum dataType);
+    // Binds itself to the currently bound vao
+    IndexBuffer();
 
     // Because we're using the VertexBufferHandle to do RAII for the buffer for us
     // and our other types are trivial or provide their own RAII
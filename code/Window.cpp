@@ -6,6 +6,7 @@
 #include "backends/imgui_impl_opengl3.h"
 
 #include <iostream>
+#include <utility>
 
 
 // ---------------------------
@@ -100,15 +101,28 @@ Window::Window(
 	: window(nullptr)
 	, callbacks(callbacks)
 {
-	// specify OpenGL version
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	// specify OpenGL version, the modern loader tries the newest context first and falls back to older ones. The GL 4.x
+	// paths check the version of the context they got
+#if defined(SOLARSYSTEM_MODERN_GL)
+	constexpr std::pair<int, int> versions[] = { { 4, 6 }, { 4, 3 }, { 3, 3 } };
+#else
+	constexpr std::pair<int, int> versions[] = { { 3, 3 } };
+#endif
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // needed for mac?
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 
 	// create window
-	window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, monitor, share));
+	for (auto const& [major, minor] : versions) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+		window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, monitor, share));
+		if (window != nullptr) {
+			Log::info("WINDOW created an OpenGL {}.{} context", major, minor);
+			break;
+		}
+		Log::warn("WINDOW failed to create an OpenGL {}.{} context", major, minor);
+	}
 	if (window == nullptr) {
 		Log::error("WINDOW failed to create GLFW window");
 		throw std::runtime_error("Failed to create GLFW window.");
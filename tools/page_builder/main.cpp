@@ -0,0 +1,70 @@
+// Offline tiling of high resolution maps for virtual texturing:
+//
+//   page_builder <image> <output.vtpages>
+//
+// The image needs power of two sides, e.g. a 16k x 8k equirectangular map. Name the output after the texture of the
+// body it replaces, assets/textures/pages/2k_earth_daymap.vtpages is used by the earth whatever the source resolution.
+// The mip chain is built gamma-correct like the runtime does, then every level is cut into bordered pages.
+
+#include "Log.h"
+#include "MipChain.hpp"
+#include "PageFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <argh.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+//======================================================================================================================
+
+int main(int argc, char** argv)
+{
+	argh::parser arguments(argc, argv);
+	if (arguments.size() < 3)
+	{
+		Log::error("Usage: page_builder <image> <output.vtpages>");
+		return 1;
+	}
+	std::string const inputPath = arguments[1];
+	std::filesystem::path const outputPath = arguments[2];
+
+	auto const start = std::chrono::steady_clock::now();
+
+	// flipped like the runtime loads the source images, so the uvs stay the same
+	stbi_set_flip_vertically_on_load(true);
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* const pixels = stbi_load(inputPath.c_str(), &width, &height, &channels, PageFile::Channels);
+	if (pixels == nullptr)
+	{
+		Log::error("Failed to read image: {}", inputPath);
+		return 1;
+	}
+	std::shared_ptr<MipChain const> const chain = Mips::Build(pixels, width, height, PageFile::Channels, *ThreadPool::Instance());
+	stbi_image_free(pixels);
+
+	std::error_code error{};
+	std::filesystem::create_directories(outputPath.parent_path(), error);
+	if (PageFile::Write(outputPath, *chain) == false)
+	{
+		Log::error("Failed to write {}", outputPath.string());
+		return 1;
+	}
+
+	std::unique_ptr<PageFile> const pages = PageFile::Load(outputPath.string());
+	if (pages == nullptr)
+	{
+		return 1;
+	}
+
+	auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	Log::info("{}: {}x{} in {} levels of pages, {} pages at the finest level in {:.1f}s",
+		outputPath.filename().string(), width, height, pages->LevelCount(), pages->PagesWide(0) * pages->PagesHigh(0), seconds);
+	return 0;
+}
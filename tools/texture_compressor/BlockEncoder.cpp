@@ -0,0 +1,521 @@
+#include "BlockEncoder.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+//======================================================================================================================
+
+namespace
+{
+	template <size_t N>
+	using Vector = std::array<float, N>;
+
+	template <size_t N>
+	float Dot(Vector<N> const& a, Vector<N> const& b)
+	{
+		float sum = 0.0f;
+		for (size_t i = 0; i < N; ++i)
+		{
+			sum += a[i] * b[i];
+		}
+		return sum;
+	}
+
+	template <size_t N>
+	Vector<N> Texel(unsigned char const* block, size_t const index)
+	{
+		Vector<N> texel{};
+		for (size_t c = 0; c < N; ++c)
+		{
+			texel[c] = static_cast<float>(block[index * 4 + c]);
+		}
+		return texel;
+	}
+
+	//==================================================================================================================
+
+	// Endpoints at the extremes of the texels projected on their principal axis, found by power iteration on the
+	// covariance matrix
+	template <size_t N>
+	void PrincipalEndpoints(unsigned char const* block, Vector<N>& first, Vector<N>& second)
+	{
+		Vector<N> mean{};
+		for (size_t i = 0; i < 16; ++i)
+		{
+			Vector<N> const texel = Texel<N>(block, i);
+			for (size_t c = 0; c < N; ++c)
+			{
+				mean[c] += texel[c] / 16.0f;
+			}
+		}
+
+		std::array<Vector<N>, N> covariance{};
+		for (size_t i = 0; i < 16; ++i)
+		{
+			Vector<N> texel = Texel<N>(block, i);
+			for (size_t c = 0; c < N; ++c)
+			{
+				texel[c] -= mean[c];
+			}
+			for (size_t r = 0; r < N; ++r)
+			{
+				for (size_t c = 0; c < N; ++c)
+				{
+					covariance[r][c] += texel[r] * texel[c];
+				}
+			}
+		}
+
+		Vector<N> axis{};
+		axis.fill(1.0f);
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			Vector<N> next{};
+			for (size_t r = 0; r < N; ++r)
+			{
+				next[r] = Dot(covariance[r], axis);
+			}
+			float const length = std::sqrt(Dot(next, next));
+			if (length < 1e-6f)
+			{
+				break; // uniform block, any axis works
+			}
+			for (size_t c = 0; c < N; ++c)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+
+		float low = std::numeric_limits<float>::max();
+		float high = std::numeric_limits<float>::lowest();
+		for (size_t i = 0; i < 16; ++i)
+		{
+			Vector<N> texel = Texel<N>(block, i);
+			for (size_t c = 0; c < N; ++c)
+			{
+				texel[c] -= mean[c];
+			}
+			float const projection = Dot(texel, axis);
+			low = std::min(low, projection);
+			high = std::max(high, projection);
+		}
+
+		for (size_t c = 0; c < N; ++c)
+		{
+			first[c] = std::clamp(mean[c] + axis[c] * high, 0.0f, 255.0f);
+			second[c] = std::clamp(mean[c] + axis[c] * low, 0.0f, 255.0f);
+		}
+	}
+
+	//==================================================================================================================
+
+	// Least squares endpoints for fixed interpolation weights, keeps the endpoints if the system is degenerate
+	template <size_t N>
+	void RefineEndpoints(unsigned char const* block, std::array<float, 16> const& weights, Vector<N>& first, Vector<N>& second)
+	{
+		// texel = (1 - w) * first + w * second
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		Vector<N> at{};
+		Vector<N> bt{};
+		for (size_t i = 0; i < 16; ++i)
+		{
+			float const a = 1.0f - weights[i];
+			float const b = weights[i];
+			Vector<N> const texel = Texel<N>(block, i);
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (size_t c = 0; c < N; ++c)
+			{
+				at[c] += a * texel[c];
+				bt[c] += b * texel[c];
+			}
+		}
+
+		float const determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			return;
+		}
+		for (size_t c = 0; c < N; ++c)
+		{
+			first[c] = std::clamp((at[c] * bb - bt[c] * ab) / determinant, 0.0f, 255.0f);
+			second[c] = std::clamp((bt[c] * aa - at[c] * ab) / determinant, 0.0f, 255.0f);
+		}
+	}
+
+	//==================================================================================================================
+
+	uint16_t To565(Vector<3> const& color)
+	{
+		auto const r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+		auto const g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+		auto const b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+		return static_cast<uint16_t>(r << 11 | g << 5 | b);
+	}
+
+	Vector<3> From565(uint16_t const color)
+	{
+		int const r = color >> 11 & 31;
+		int const g = color >> 5 & 63;
+		int const b = color & 31;
+		return { static_cast<float>(r << 3 | r >> 2), static_cast<float>(g << 2 | g >> 4), static_cast<float>(b << 3 | b >> 2) };
+	}
+
+	//==================================================================================================================
+
+	// Picks the nearest of the four-color palette for every texel, returns the squared error
+	float BC1Indices(unsigned char const* block, uint16_t const color0, uint16_t const color1, uint32_t& indices)
+	{
+		Vector<3> const c0 = From565(color0);
+		Vector<3> const c1 = From565(color1);
+		std::array<Vector<3>, 4> palette{ c0, c1, {}, {} };
+		for (size_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2.0f * c0[c] + c1[c]) / 3.0f;
+			palette[3][c] = (c0[c] + 2.0f * c1[c]) / 3.0f;
+		}
+
+		float error = 0.0f;
+		indices = 0;
+		for (size_t i = 0; i < 16; ++i)
+		{
+			Vector<3> const texel = Texel<3>(block, i);
+			uint32_t best = 0;
+			float bestError = std::numeric_limits<float>::max();
+			for (uint32_t p = 0; p < 4; ++p)
+			{
+				Vector<3> difference{};
+				for (size_t c = 0; c < 3; ++c)
+				{
+					difference[c] = texel[c] - palette[p][c];
+				}
+				float const e = Dot(difference, difference);
+				if (e < bestError)
+				{
+					bestError = e;
+					best = p;
+				}
+			}
+			indices |= best << (2 * i);
+			error += bestError;
+		}
+		return error;
+	}
+
+	//==================================================================================================================
+
+	void WriteBC1(uint16_t color0, uint16_t color1, uint32_t indices, std::byte* output)
+	{
+		std::memcpy(output, &color0, 2);
+		std::memcpy(output + 2, &color1, 2);
+		std::memcpy(output + 4, &indices, 4);
+	}
+
+	//==================================================================================================================
+
+	// Writes bits least significant first, as the BC7 block layout is defined
+	class BitWriter
+	{
+	public:
+
+		explicit BitWriter(std::byte* output) : mOutput(output) { std::memset(output, 0, 16); }
+
+		void Write(uint32_t const value, int const bitCount)
+		{
+			for (int bit = 0; bit < bitCount; ++bit, ++mPosition)
+			{
+				if ((value >> bit & 1u) != 0)
+				{
+					mOutput[mPosition / 8] |= static_cast<std::byte>(1u << (mPosition % 8));
+				}
+			}
+		}
+
+	private:
+
+		std::byte* mOutput;
+		int mPosition = 0;
+	};
+}
+
+//======================================================================================================================
+
+void BlockEncoder::EncodeBC1(unsigned char const* block, std::byte* output)
+{
+	Vector<3> first{};
+	Vector<3> second{};
+	PrincipalEndpoints<3>(block, first, second);
+
+	uint16_t color0 = To565(first);
+	uint16_t color1 = To565(second);
+	uint32_t indices = 0;
+	float error = BC1Indices(block, color0, color1, indices);
+
+	// refit the endpoints to the chosen indices once and keep the result if it is better
+	constexpr std::array<float, 4> IndexWeights = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	std::array<float, 16> weights{};
+	for (size_t i = 0; i < 16; ++i)
+	{
+		weights[i] = IndexWeights[indices >> (2 * i) & 3u];
+	}
+	RefineEndpoints<3>(block, weights, first, second);
+	uint16_t const refined0 = To565(first);
+	uint16_t const refined1 = To565(second);
+	uint32_t refinedIndices = 0;
+	float const refinedError = BC1Indices(block, refined0, refined1, refinedIndices);
+	if (refinedError < error)
+	{
+		color0 = refined0;
+		color1 = refined1;
+		indices = refinedIndices;
+		error = refinedError;
+	}
+
+	// the four-color mode needs color0 > color1, swapping the endpoints maps index 0<->1 and 2<->3
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+		indices ^= 0x55555555u;
+	}
+	else if (color0 == color1)
+	{
+		indices = 0; // every texel is color0 in either mode
+	}
+	WriteBC1(color0, color1, indices, output);
+}
+
+//======================================================================================================================
+
+void BlockEncoder::EncodeBC4(unsigned char const* block, std::byte* output)
+{
+	unsigned char low = 255;
+	unsigned char high = 0;
+	for (size_t i = 0; i < 16; ++i)
+	{
+		low = std::min(low, block[i * 4]);
+		high = std::max(high, block[i * 4]);
+	}
+
+	// eight value mode, value0 > value1, with six values interpolated between them
+	std::array<float, 8> palette{ static_cast<float>(high), static_cast<float>(low) };
+	for (int i = 2; i < 8; ++i)
+	{
+		palette[i] = (static_cast<float>(8 - i) * high + static_cast<float>(i - 1) * low) / 7.0f;
+	}
+
+	uint64_t indices = 0;
+	for (size_t i = 0; i < 16; ++i)
+	{
+		float const value = block[i * 4];
+		uint64_t best = 0;
+		for (uint64_t p = 1; p < 8; ++p)
+		{
+			if (std::fabs(value - palette[p]) < std::fabs(value - palette[best]))
+			{
+				best = p;
+			}
+		}
+		indices |= best << (3 * i);
+	}
+
+	output[0] = static_cast<std::byte>(high);
+	output[1] = static_cast<std::byte>(low);
+	for (size_t byte = 0; byte < 6; ++byte)
+	{
+		output[2 + byte] = static_cast<std::byte>(indices >> (8 * byte) & 0xFFu);
+	}
+}
+
+//======================================================================================================================
+
+void BlockEncoder::EncodeBC3(unsigned char const* block, std::byte* output)
+{
+	// the alpha half is a bc4 block of the alpha channel
+	std::array<unsigned char, 64> alpha{};
+	for (size_t i = 0; i < 16; ++i)
+	{
+		alpha[i * 4] = block[i * 4 + 3];
+	}
+	EncodeBC4(alpha.data(), output);
+
+	// the color half is always decoded in four-color mode, equal endpoints are fine here
+	EncodeBC1(block, output + 8);
+}
+
+//======================================================================================================================
+
+void BlockEncoder::EncodeBC7(unsigned char const* block, std::byte* output)
+{
+	constexpr std::array<int, 16> Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	Vector<4> first{};
+	Vector<4> second{};
+	PrincipalEndpoints<4>(block, first, second);
+
+	// each endpoint is 7 bits per channel plus a p-bit shared by its channels, pick the p-bit closer to the endpoint
+	auto const quantize = [](Vector<4> const& endpoint, std::array<int, 4>& quantized, int& pBit)->void
+	{
+		float bestError = std::numeric_limits<float>::max();
+		for (int p = 0; p < 2; ++p)
+		{
+			std::array<int, 4> candidate{};
+			float error = 0.0f;
+			for (size_t c = 0; c < 4; ++c)
+			{
+				candidate[c] = std::clamp(static_cast<int>(std::lround((endpoint[c] - static_cast<float>(p)) / 2.0f)), 0, 127);
+				float const difference = static_cast<float>(candidate[c] << 1 | p) - endpoint[c];
+				error += difference * difference;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				quantized = candidate;
+				pBit = p;
+			}
+		}
+	};
+
+	auto const encode = [&block, &Weights, &quantize](Vector<4> const& e0, Vector<4> const& e1, std::array<int, 4>& q0, std::array<int, 4>& q1,
+		int& p0, int& p1, std::array<int, 16>& indices)->float
+	{
+		quantize(e0, q0, p0);
+		quantize(e1, q1, p1);
+		std::array<Vector<4>, 16> palette{};
+		for (size_t w = 0; w < 16; ++w)
+		{
+			for (size_t c = 0; c < 4; ++c)
+			{
+				int const a = q0[c] << 1 | p0;
+				int const b = q1[c] << 1 | p1;
+				palette[w][c] = static_cast<float>(((64 - Weights[w]) * a + Weights[w] * b + 32) >> 6);
+			}
+		}
+
+		float error = 0.0f;
+		for (size_t i = 0; i < 16; ++i)
+		{
+			Vector<4> const texel = Texel<4>(block, i);
+			float bestError = std::numeric_limits<float>::max();
+			for (int w = 0; w < 16; ++w)
+			{
+				Vector<4> difference{};
+				for (size_t c = 0; c < 4; ++c)
+				{
+					difference[c] = texel[c] - palette[w][c];
+				}
+				float const e = Dot(difference, difference);
+				if (e < bestError)
+				{
+					bestError = e;
+					indices[i] = w;
+				}
+			}
+			error += bestError;
+		}
+		return error;
+	};
+
+	std::array<int, 4> q0{};
+	std::array<int, 4> q1{};
+	int p0 = 0;
+	int p1 = 0;
+	std::array<int, 16> indices{};
+	float const error = encode(first, second, q0, q1, p0, p1, indices);
+
+	std::array<float, 16> weights{};
+	for (size_t i = 0; i < 16; ++i)
+	{
+		weights[i] = static_cast<float>(Weights[indices[i]]) / 64.0f;
+	}
+	RefineEndpoints<4>(block, weights, first, second);
+	std::array<int, 4> refined0{};
+	std::array<int, 4> refined1{};
+	int refinedP0 = 0;
+	int refinedP1 = 0;
+	std::array<int, 16> refinedIndices{};
+	if (encode(first, second, refined0, refined1, refinedP0, refinedP1, refinedIndices) < error)
+	{
+		q0 = refined0;
+		q1 = refined1;
+		p0 = refinedP0;
+		p1 = refinedP1;
+		indices = refinedIndices;
+	}
+
+	// the first index is stored without its top bit, which therefore has to be 0
+	if (indices[0] >= 8)
+	{
+		std::swap(q0, q1);
+		std::swap(p0, p1);
+		for (int& index : indices)
+		{
+			index = 15 - index;
+		}
+	}
+
+	BitWriter writer(output);
+	writer.Write(1u << 6, 7); // mode 6
+	for (size_t c = 0; c < 4; ++c)
+	{
+		writer.Write(static_cast<uint32_t>(q0[c]), 7);
+		writer.Write(static_cast<uint32_t>(q1[c]), 7);
+	}
+	writer.Write(static_cast<uint32_t>(p0), 1);
+	writer.Write(static_cast<uint32_t>(p1), 1);
+	writer.Write(static_cast<uint32_t>(indices[0]), 3);
+	for (size_t i = 1; i < 16; ++i)
+	{
+		writer.Write(static_cast<uint32_t>(indices[i]), 4);
+	}
+}
+
+//======================================================================================================================
+
+std::vector<std::byte> BlockEncoder::EncodeLevel(BlockFormat const format, unsigned char const* pixels, int const width, int const height, ThreadPool& pool)
+{
+	int const blocksWide = std::max((width + 3) / 4, 1);
+	int const blocksHigh = std::max((height + 3) / 4, 1);
+	size_t const blockBytes = BlockFormats::BlockBytes(format);
+	std::vector<std::byte> encoded(BlockFormats::LevelSize(format, width, height));
+
+	pool.ParallelFor(0, blocksHigh, 4, [&](int const firstRow, int const endRow)->void
+	{
+		std::array<unsigned char, 64> block{};
+		for (int blockY = firstRow; blockY < endRow; ++blockY)
+		{
+			for (int blockX = 0; blockX < blocksWide; ++blockX)
+			{
+				for (int y = 0; y < 4; ++y)
+				{
+					int const sourceY = std::min(blockY * 4 + y, height - 1);
+					for (int x = 0; x < 4; ++x)
+					{
+						int const sourceX = std::min(blockX * 4 + x, width - 1);
+						std::memcpy(&block[static_cast<size_t>(y * 4 + x) * 4], pixels + (static_cast<size_t>(sourceY) * static_cast<size_t>(width) + static_cast<size_t>(sourceX)) * 4, 4);
+					}
+				}
+
+				std::byte* output = encoded.data() + (static_cast<size_t>(blockY) * static_cast<size_t>(blocksWide) + static_cast<size_t>(blockX)) * blockBytes;
+				switch (format)
+				{
+				case BlockFormat::BC1: EncodeBC1(block.data(), output); break;
+				case BlockFormat::BC3: EncodeBC3(block.data(), output); break;
+				case BlockFormat::BC4: EncodeBC4(block.data(), output); break;
+				case BlockFormat::BC7: EncodeBC7(block.data(), output); break;
+				}
+			}
+		}
+	});
+	return encoded;
+}
+
+//======================================================================================================================
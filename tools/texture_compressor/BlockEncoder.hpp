@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CompressedImage.hpp"
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// CPU encoders for 4x4 blocks of rgba8 texels, 64 bytes in row-major order.
+// The endpoints come from the principal axis of the block's colors and are refined once by least squares, which is
+// close to the quality of the reference encoders at a fraction of their search time
+namespace BlockEncoder
+{
+	// 8 bytes, always the four-color mode, alpha is ignored
+	void EncodeBC1(unsigned char const* block, std::byte* output);
+
+	// 16 bytes, bc4 alpha followed by bc1 color
+	void EncodeBC3(unsigned char const* block, std::byte* output);
+
+	// 8 bytes from the red channel
+	void EncodeBC4(unsigned char const* block, std::byte* output);
+
+	// 16 bytes in mode 6: one subset of rgba endpoints with 7 bits and a p-bit per endpoint, 4-bit indices
+	void EncodeBC7(unsigned char const* block, std::byte* output);
+
+	// Encodes a whole rgba8 level, blocks over the edge repeat the last row/column. Rows of blocks are spread over
+	// the pool
+	[[nodiscard]]
+	std::vector<std::byte> EncodeLevel(BlockFormat format, unsigned char const* pixels, int width, int height, ThreadPool& pool);
+}
@@ -0,0 +1,108 @@
+// Offline block compression of the textures, run through the compress_textures target:
+//
+//   texture_compressor <image> <output.ktx2> [--format=bc1|bc3|bc4|bc7] [--srgb]
+//
+// Without --format images with alpha become BC3, single channel images BC4 and the rest BC1. The mip chain is built
+// gamma-correct like the runtime does for uncompressed images, then every level is block compressed. --srgb labels
+// the file with the sRGB VkFormat and transfer function, the runtime reads both variants the same way.
+
+#include "BlockEncoder.hpp"
+#include "CompressedImage.hpp"
+#include "Log.h"
+#include "MipChain.hpp"
+#include "ThreadPool.hpp"
+
+#include <argh.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+//======================================================================================================================
+
+static std::optional<BlockFormat> ParseFormat(std::string const& name)
+{
+	if (name == "bc1") return BlockFormat::BC1;
+	if (name == "bc3") return BlockFormat::BC3;
+	if (name == "bc4") return BlockFormat::BC4;
+	if (name == "bc7") return BlockFormat::BC7;
+	return std::nullopt;
+}
+
+//======================================================================================================================
+
+int main(int argc, char** argv)
+{
+	argh::parser arguments(argc, argv);
+	if (arguments.size() < 3)
+	{
+		Log::error("Usage: texture_compressor <image> <output.ktx2> [--format=bc1|bc3|bc4|bc7] [--srgb]");
+		return 1;
+	}
+	std::string const inputPath = arguments[1];
+	std::filesystem::path const outputPath = arguments[2];
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	if (stbi_info(inputPath.c_str(), &width, &height, &channels) == 0)
+	{
+		Log::error("Failed to read image header: {}", inputPath);
+		return 1;
+	}
+
+	BlockFormat format = channels == 4 ? BlockFormat::BC3 : channels == 1 ? BlockFormat::BC4 : BlockFormat::BC1;
+	std::string formatName{};
+	if (arguments("format") >> formatName)
+	{
+		std::optional<BlockFormat> const requested = ParseFormat(formatName);
+		if (requested.has_value() == false)
+		{
+			Log::error("Unknown format {}", formatName);
+			return 1;
+		}
+		format = *requested;
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+
+	// flipped like the runtime loads the source images, so the uvs stay the same
+	stbi_set_flip_vertically_on_load(true);
+	stbi_uc* const pixels = stbi_load(inputPath.c_str(), &width, &height, &channels, 4);
+	if (pixels == nullptr)
+	{
+		Log::error("Failed to read image: {}", inputPath);
+		return 1;
+	}
+	std::shared_ptr<ThreadPool> const pool = ThreadPool::Instance();
+	std::shared_ptr<MipChain const> const chain = Mips::Build(pixels, width, height, 4, *pool);
+	stbi_image_free(pixels);
+
+	std::vector<std::vector<std::byte>> levels{};
+	size_t compressedSize = 0;
+	for (size_t level = 0; level < chain->levels.size(); ++level)
+	{
+		MipChain::Level const& mip = chain->levels[level];
+		levels.push_back(BlockEncoder::EncodeLevel(format, chain->Data(level), mip.width, mip.height, *pool));
+		compressedSize += levels.back().size();
+	}
+
+	std::error_code error{};
+	std::filesystem::create_directories(outputPath.parent_path(), error);
+	if (Ktx2::Write(outputPath, format, width, height, levels, arguments["srgb"]) == false)
+	{
+		Log::error("Failed to write {}", outputPath.string());
+		return 1;
+	}
+
+	auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	size_t const uncompressedSize = static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(channels) * 4 / 3;
+	Log::info("{}: {}x{} {} with {} levels, {:.1f} MiB instead of {:.1f} MiB in {:.1f}s",
+		outputPath.filename().string(), width, height, BlockFormats::Name(format), levels.size(),
+		static_cast<double>(compressedSize) / (1024.0 * 1024.0), static_cast<double>(uncompressedSize) / (1024.0 * 1024.0), seconds);
+	return 0;
+}